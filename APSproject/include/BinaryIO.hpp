@@ -0,0 +1,93 @@
+#ifndef BINARY_IO_HPP
+#define BINARY_IO_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Helpers for the persisted index format. Values are written in host byte
+// order with fixed widths; strings are a uint32_t length followed by bytes.
+class BinaryWriter {
+public:
+    template <typename T>
+    void write(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "write() needs a trivially copyable type");
+        writeBytes(&value, sizeof(T));
+    }
+
+    void writeBytes(const void* data, size_t size) {
+        buffer_.append(static_cast<const char*>(data), size);
+    }
+
+    void writeString(std::string_view value) {
+        write(static_cast<uint32_t>(value.size()));
+        writeBytes(value.data(), value.size());
+    }
+
+    // Pad with zeros up to a multiple of alignment
+    void align(size_t alignment) {
+        buffer_.append((alignment - buffer_.size() % alignment) % alignment, '\0');
+    }
+
+    // Pad with zeros up to offset
+    void padTo(size_t offset) {
+        if (offset > buffer_.size()) buffer_.append(offset - buffer_.size(), '\0');
+    }
+
+    // Overwrite a value written earlier at offset
+    template <typename T>
+    void patch(size_t offset, const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "patch() needs a trivially copyable type");
+        std::memcpy(&buffer_[offset], &value, sizeof(T));
+    }
+
+    const std::string& data() const { return buffer_; }
+    size_t size() const { return buffer_.size(); }
+
+private:
+    std::string buffer_;
+};
+
+// Bounds-checked reader over a byte range; throws std::runtime_error when a
+// read runs past the end, so truncated files are rejected
+class BinaryReader {
+public:
+    BinaryReader(const char* data, size_t size) : data_(data), size_(size) {}
+
+    template <typename T>
+    T read() {
+        static_assert(std::is_trivially_copyable_v<T>, "read() needs a trivially copyable type");
+        T value;
+        std::memcpy(&value, readBytes(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    // Get a pointer to the next size bytes and skip them
+    const char* readBytes(size_t size) {
+        if (size > size_ - offset_) {
+            throw std::runtime_error("Truncated index data");
+        }
+        const char* bytes = data_ + offset_;
+        offset_ += size;
+        return bytes;
+    }
+
+    std::string_view readString() {
+        uint32_t length = read<uint32_t>();
+        return std::string_view(readBytes(length), length);
+    }
+
+    size_t offset() const { return offset_; }
+    size_t remaining() const { return size_ - offset_; }
+
+private:
+    const char* data_;
+    size_t size_;
+    size_t offset_{0};
+};
+
+#endif // BINARY_IO_HPP
\ No newline at end of file
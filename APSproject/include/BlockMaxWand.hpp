@@ -0,0 +1,34 @@
+#ifndef BLOCK_MAX_WAND_HPP
+#define BLOCK_MAX_WAND_HPP
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "PostingCursor.hpp"
+#include "TFIDFCalculator.hpp"
+#include "TopKCollector.hpp"
+
+// Document-at-a-time top-k retrieval with Block-Max WAND dynamic pruning
+// (Ding & Suel, 2011). Per-term and per-block score upper bounds let the
+// evaluator skip documents that cannot beat the current k-th best score
+// without decoding or scoring them.
+class BlockMaxWand {
+public:
+    // One query term: a cursor over its postings plus its weights
+    struct Term {
+        PostingCursor cursor;
+        double idf;
+        uint32_t max_term_frequency;
+    };
+
+    explicit BlockMaxWand(const TFIDFCalculator& calculator) : calculator_(calculator) {}
+
+    // Return up to k (doc_id, score) pairs with positive scores, best first.
+    // Produces the same documents and scores as exhaustive TF-IDF scoring.
+    std::vector<std::pair<uint32_t, double>> search(std::vector<Term> terms, size_t k) const;
+
+private:
+    const TFIDFCalculator& calculator_;
+};
+
+#endif // BLOCK_MAX_WAND_HPP
\ No newline at end of file
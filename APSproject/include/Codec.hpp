@@ -0,0 +1,40 @@
+#ifndef CODEC_HPP
+#define CODEC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Entropy coder for blocks of compressed index files. Streams describe
+// themselves: decompress() needs only the stream and the output size, so
+// blocks are decoded independently and in parallel. Files record the codec
+// ID, which lets every file pick its own codec.
+class Codec {
+public:
+    // Stored in files; never renumber
+    enum class Id : uint32_t {
+        Huffman = 1,
+        Rans = 2
+    };
+
+    virtual ~Codec() = default;
+
+    virtual Id id() const = 0;
+
+    // Compress size bytes into a self-describing stream
+    virtual std::vector<unsigned char> compress(const char* data, size_t size) const = 0;
+
+    // Decompress a stream into out. Throws std::runtime_error unless it is
+    // a valid stream of exactly out_size bytes.
+    virtual void decompress(const unsigned char* data, size_t size, char* out, size_t out_size) const = 0;
+
+    // Largest output a stream could decode to, judged from its header and
+    // length without decoding it; 0 if it cannot be valid. Lets readers
+    // reject impossible sizes before allocating for them.
+    virtual uint64_t maxDecodedSize(const unsigned char* data, size_t size) const = 0;
+
+    // Shared instance of a codec, or nullptr for an unknown ID
+    static const Codec* get(Id id);
+};
+
+#endif // CODEC_HPP
\ No newline at end of file
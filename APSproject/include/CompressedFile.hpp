@@ -0,0 +1,73 @@
+#ifndef COMPRESSED_FILE_HPP
+#define COMPRESSED_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Codec.hpp"
+#include "ThreadPool.hpp"
+
+// Framed container of independently compressed blocks. Every block is a
+// self-describing stream of the file's codec with its own model, so blocks
+// are coded in parallel, and a block index at the end of the file lets
+// readers decode them in parallel too.
+//
+// Layout (host byte order):
+//   magic "APSBLOCK", uint32_t version, uint32_t block size, uint32_t codec
+//   compressed blocks
+//   BlockEntry[block_count]
+//   uint64_t block_count, uint64_t block index offset, magic "APSBLKIX"
+class CompressedFile {
+public:
+    static constexpr uint32_t kFormatVersion = 2;
+    static constexpr size_t kDefaultBlockSize = size_t{1} << 20;
+
+    // Streams bytes into a container. Full blocks are compressed on the
+    // pool and written in order as they finish; at most two blocks per
+    // worker are in flight, so memory stays bounded whatever the total.
+    class Writer {
+    public:
+        Writer(std::ostream& out, ThreadPool& pool, const Codec& codec,
+               size_t block_size = kDefaultBlockSize);
+
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+
+        // Append raw bytes
+        void write(const char* data, size_t size);
+
+        // Compress the last block and write the block index. Returns false
+        // if the output stream failed.
+        bool finish();
+
+    private:
+        std::ostream& out_;
+        ThreadPool& pool_;
+        const Codec& codec_;
+        size_t block_size_;
+        std::string buffer_;
+        std::deque<std::pair<size_t, std::future<std::vector<unsigned char>>>> pending_;  // Raw size, block
+        std::vector<uint64_t> index_;   // Offset, compressed size, raw size per block
+        uint64_t offset_;
+
+        void submitBlock();
+        void writeOldestBlock();
+    };
+
+    // Check whether bytes start like a container
+    static bool isCompressed(const char* data, size_t size);
+
+    // Decode a whole container, spreading its blocks over the pool. Throws
+    // std::runtime_error if the container is damaged or its codec unknown.
+    // Sizes are checked against the block streams before anything is
+    // allocated, but valid blocks of one repeated byte can still decode to
+    // more than fits in memory (std::bad_alloc).
+    static std::string decompress(const char* data, size_t size, ThreadPool& pool);
+};
+
+#endif // COMPRESSED_FILE_HPP
\ No newline at end of file
@@ -0,0 +1,23 @@
+#ifndef CPU_FEATURES_HPP
+#define CPU_FEATURES_HPP
+
+// SIMD kernels are compiled for specific instruction sets with a function
+// attribute and selected at runtime, so the baseline build stays portable.
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define SEARCH_ENGINE_X86 1
+#if defined(__GNUC__) || defined(__clang__)
+#define SEARCH_ENGINE_TARGET(isa) __attribute__((target(isa)))
+#else
+#define SEARCH_ENGINE_TARGET(isa)
+#endif
+#endif
+
+// Runtime detection of the instruction set extensions used by SIMD kernels
+class CpuFeatures {
+public:
+    static bool hasSSE2();
+    static bool hasSSSE3();
+    static bool hasAVX2();
+};
+
+#endif // CPU_FEATURES_HPP
\ No newline at end of file
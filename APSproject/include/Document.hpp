@@ -2,30 +2,53 @@
 #define DOCUMENT_HPP
 
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <deque>
+#include <vector>
+#include <cstdint>
 #include <memory>
 
 class Document {
 public:
+    // A word's occurrences in the document. Positions are token indexes,
+    // ascending, and only recorded when parsing asks for them.
+    struct WordOccurrences {
+        uint32_t frequency{0};
+        std::vector<uint32_t> positions;
+    };
+    
     Document(const std::string& id, const std::string& path);
     
-    // Parse and process the document content
-    bool parse();
+    // The word map holds views into words_, so copies rebuild it
+    Document(const Document& other);
+    Document& operator=(const Document& other);
+    Document(Document&&) = default;
+    Document& operator=(Document&&) = default;
+    
+    // Parse and process the document content. The file is memory-mapped and
+    // tokenized in place (see Tokenizer); a string is only allocated for each
+    // distinct word. Positions, which only phrase and NEAR queries need, are
+    // recorded if record_positions is set.
+    bool parse(bool record_positions = true);
     
     // Getters
     const std::string& getId() const { return id_; }
     const std::string& getPath() const { return path_; }
-    const std::unordered_map<std::string, size_t>& getWordFrequencies() const { return word_frequencies_; }
+    const std::unordered_map<std::string_view, WordOccurrences>& getWordOccurrences() const { return word_occurrences_; }
+    bool hasPositions() const { return has_positions_; }
     size_t getWordCount() const { return total_words_; }
     
 private:
     std::string id_;                    // Unique document identifier
     std::string path_;                  // Path to the document file
-    std::unordered_map<std::string, size_t> word_frequencies_;  // Word frequency map
+    std::deque<std::string> words_;     // Distinct words; a deque keeps them in place
+    std::unordered_map<std::string_view, WordOccurrences> word_occurrences_;
     size_t total_words_;               // Total number of words in document
+    bool has_positions_;               // Whether parse() recorded positions
     
-    // Helper function to process text
-    void processWord(const std::string& word);
+    // Count a normalized word and, if recording, its position
+    void processWord(std::string_view word);
 };
 
-#endif // DOCUMENT_HPP 
\ No newline at end of file
+#endif // DOCUMENT_HPP
\ No newline at end of file
@@ -0,0 +1,95 @@
+#ifndef EPOCH_MANAGER_HPP
+#define EPOCH_MANAGER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+// Epoch-based reclamation (Fraser, 2004) for objects that readers reach
+// through an atomic pointer without taking locks. A reader pins the global
+// epoch in a Guard for the duration of its access; a writer that unlinks an
+// object retires it, and the object is freed once every reader that could
+// still hold it has unpinned.
+class EpochManager {
+private:
+    struct Slot;
+
+public:
+    // Pins the epoch while alive. Guards are movable, so a pin may outlive
+    // the call that took it (e.g. inside a result iterator).
+    class Guard {
+    public:
+        explicit Guard(EpochManager& manager);
+        ~Guard();
+
+        Guard(Guard&& other) noexcept : slot_(other.slot_) { other.slot_ = nullptr; }
+        Guard& operator=(Guard&& other) noexcept;
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+    private:
+        Slot* slot_;
+
+        void release();
+    };
+
+    EpochManager() = default;
+
+    // Frees every retired object; no guard may outlive the manager
+    ~EpochManager();
+
+    EpochManager(const EpochManager&) = delete;
+    EpochManager& operator=(const EpochManager&) = delete;
+
+    // Defer a deletion until readers pinned before this call have unpinned.
+    // Call after the object has been unlinked from every shared pointer.
+    void retire(std::function<void()> deleter);
+
+    // Run the deleters of retired objects no pinned reader can hold;
+    // returns the number of objects freed
+    size_t reclaim();
+
+    // Number of retired objects not yet freed
+    size_t pendingCount() const;
+
+private:
+    static constexpr uint64_t kIdle = std::numeric_limits<uint64_t>::max();
+    static constexpr size_t kSlotsPerBlock = 64;
+
+    // Per-reader announcement, padded so pins on different slots do not
+    // share a cache line
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> epoch{kIdle};
+        std::atomic<bool> in_use{false};
+    };
+
+    // Slots are allocated in blocks that are never freed before the
+    // manager, so any number of concurrent readers can pin
+    struct SlotBlock {
+        Slot slots[kSlotsPerBlock];
+        std::atomic<SlotBlock*> next{nullptr};
+    };
+
+    struct Retired {
+        uint64_t epoch;
+        std::function<void()> deleter;
+    };
+
+    std::atomic<uint64_t> global_epoch_{0};
+    SlotBlock first_block_;
+
+    mutable std::mutex retired_mutex_;
+    std::vector<Retired> retired_;
+
+    // Claim a free slot, starting the scan at a per-thread offset
+    Slot* acquireSlot();
+
+    // Smallest epoch announced by a pinned reader, or kIdle
+    uint64_t minimumPinnedEpoch() const;
+};
+
+#endif // EPOCH_MANAGER_HPP
\ No newline at end of file
@@ -1,42 +1,40 @@
 #ifndef HUFFMAN_COMPRESSION_HPP
 #define HUFFMAN_COMPRESSION_HPP
 
+#include <cstdint>
 #include <string>
-#include <queue>
-#include <unordered_map>
-#include <memory>
 #include <vector>
+#include "Codec.hpp"
 
-class HuffmanCompression {
-private:
-    struct Node {
-        char character;
-        size_t frequency;
-        std::shared_ptr<Node> left;
-        std::shared_ptr<Node> right;
-        
-        Node(char c, size_t freq) : character(c), frequency(freq), left(nullptr), right(nullptr) {}
-        Node(size_t freq, std::shared_ptr<Node> l, std::shared_ptr<Node> r) 
-            : character('\0'), frequency(freq), left(l), right(r) {}
-    };
-    
-    struct CompareNodes {
-        bool operator()(const std::shared_ptr<Node>& a, const std::shared_ptr<Node>& b) {
-            return a->frequency > b->frequency;
-        }
-    };
+// Byte-level Huffman coder. Codes are canonical: they follow from the code
+// lengths alone, so each compressed stream carries just the lengths and
+// decodes without the encoder's state, and decompress() resolves symbols
+// with lookup tables instead of walking a tree bit by bit.
+//
+// Stream layout: uint64_t original size (little-endian), a 256-bit bitmap
+// of the bytes that occur, their 5-bit code lengths in byte order, then the
+// MSB-first code bits. Empty input compresses to an empty stream.
+class HuffmanCompression : public Codec {
+public:
+    // Longest code the encoder emits
+    static constexpr int kMaxCodeLength = 24;
     
-    std::shared_ptr<Node> root_;
-    std::unordered_map<char, std::string> encoding_map_;
+    // Compress a string and return compressed data
+    std::vector<unsigned char> compress(const std::string& data) const;
+    std::vector<unsigned char> compress(const char* data, size_t size) const override;
     
-    void buildEncodingMap(const std::shared_ptr<Node>& node, const std::string& code);
+    // Decompress data back to string. Throws std::runtime_error if the data
+    // is not a valid stream.
+    std::string decompress(const std::vector<unsigned char>& compressed_data) const;
     
-public:
-    // Compress a string and return compressed data
-    std::vector<unsigned char> compress(const std::string& data);
+    // Decompress a stream into out. Throws std::runtime_error unless it is a
+    // valid stream of exactly out_size bytes.
+    void decompress(const unsigned char* data, size_t size, char* out, size_t out_size) const override;
+
+    // The declared size, if every byte of it can take at least one bit
+    uint64_t maxDecodedSize(const unsigned char* data, size_t size) const override;
     
-    // Decompress data back to string
-    std::string decompress(const std::vector<unsigned char>& compressed_data);
+    Id id() const override { return Id::Huffman; }
     
     // Save compressed data to file
     bool saveToFile(const std::string& filename, const std::vector<unsigned char>& compressed_data);
@@ -0,0 +1,153 @@
+#ifndef INDEX_SEGMENT_HPP
+#define INDEX_SEGMENT_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "BinaryIO.hpp"
+#include "InvertedIndex.hpp"
+#include "PostingList.hpp"
+#include "PositionList.hpp"
+#include "TermDictionary.hpp"
+
+// Immutable index segment whose storage format is also its in-memory
+// representation. Every section is addressed by offset from the segment
+// start, so a segment inside a memory-mapped file is queried in place:
+// opening one costs O(1), and processes mapping the same file share its
+// pages through the OS page cache. Damaged bytes never fail a query: a
+// term's postings are checked the first time it is looked up, and a term
+// that fails is treated as absent.
+//
+// Layout (host byte order, sections 8-byte aligned):
+//   Header
+//   TermEntry[term_count]      by term ID, which is the term's rank in byte
+//                              order
+//   term dictionary            TermDictionary automaton of the terms
+//   postings                   per term: BlockInfo[blocks], encoded block
+//                              data, uncompressed tail postings, impacts,
+//                              position offsets and encoded positions
+//   DocumentEntry[doc_count]   indexed by document ID
+//   uint32_t[doc_count]        document IDs sorted by document id string
+//   document strings
+class IndexSegment {
+public:
+    static constexpr uint32_t kFormatVersion = 3;
+
+    // Open segment bytes in place. owner keeps them alive (a mapped file or
+    // a buffer). Only the header and section bounds are checked here.
+    // Throws std::runtime_error if the bytes are not a valid segment.
+    IndexSegment(std::shared_ptr<const void> owner, const char* data, size_t size);
+
+    // Append an in-memory index to writer as a segment, at an 8-byte
+    // aligned offset. Impacts and positions are included if the index
+    // stores them.
+    static void write(const InvertedIndex& index, BinaryWriter& writer);
+
+    // Build a segment in memory from an index
+    static std::shared_ptr<const IndexSegment> fromIndex(const InvertedIndex& index);
+
+    // Merge segments into one whose documents follow in segment order, so a
+    // document's ID becomes its old ID plus the sizes of the segments before
+    // it. Impacts are stored if store_impacts is set; positions are kept if
+    // every input segment has them.
+    static std::shared_ptr<const IndexSegment> merge(
+        const std::vector<std::shared_ptr<const IndexSegment>>& segments, bool store_impacts);
+
+    // Get the ID of a term, or InvertedIndex::kInvalidId if it is absent or
+    // its entry is damaged. The first lookup of a term decodes its postings
+    // and positions once to check their bounds, order and document IDs.
+    // The accessors below take IDs returned by this.
+    uint32_t getTermId(std::string_view term) const;
+
+    // Get the term spelled by an ID
+    std::string getTerm(uint32_t term_id) const { return dictionary_.getTerm(term_id); }
+
+    // The segment's terms, for prefix, range and automaton queries
+    const TermDictionary& getDictionary() const { return dictionary_; }
+
+    // Postings of a term, viewed in place
+    PostingList::View getPostings(uint32_t term_id) const;
+
+    // Quantized TF impacts parallel to the postings, or nullptr if the
+    // segment was written without impacts
+    const uint8_t* getImpacts(uint32_t term_id) const;
+    bool hasImpacts() const { return (header_->flags & kHasImpacts) != 0; }
+
+    // Token positions parallel to the postings; not available() if the
+    // segment was written without positions
+    PositionList::View getPositions(uint32_t term_id) const;
+    bool hasPositions() const { return (header_->flags & kHasPositions) != 0; }
+
+    uint32_t getMaxTermFrequency(uint32_t term_id) const { return terms_[term_id].max_term_frequency; }
+    size_t getDocumentFrequency(uint32_t term_id) const { return terms_[term_id].size; }
+
+    // Document table, by dense document ID; empty for a damaged entry
+    std::string_view getDocumentId(uint32_t doc_id) const;
+    std::string_view getDocumentPath(uint32_t doc_id) const;
+
+    // Get the dense ID of a document id, or InvertedIndex::kInvalidId
+    uint32_t findDocument(std::string_view id) const;
+
+    size_t getTermCount() const { return header_->term_count; }
+    size_t getTotalDocuments() const { return header_->doc_count; }
+
+    // The segment's bytes, e.g. for copying it into another file
+    std::string_view bytes() const { return {data_, size_}; }
+
+private:
+    static constexpr uint32_t kHasImpacts = 1;
+    static constexpr uint32_t kHasPositions = 2;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t flags;
+        uint32_t term_count;
+        uint32_t doc_count;
+        uint64_t terms_offset;
+        uint64_t dictionary_offset;
+        uint64_t postings_offset;
+        uint64_t documents_offset;
+        uint64_t document_order_offset;
+        uint64_t document_strings_offset;
+        uint64_t size;
+    };
+
+    struct TermEntry {
+        uint64_t postings_offset;   // Relative to the postings section
+        uint32_t size;              // Number of postings
+        uint32_t data_size;         // Bytes of encoded block data
+        uint32_t max_term_frequency;
+        uint32_t positions_size;    // Bytes of encoded positions
+    };
+
+    struct DocumentEntry {
+        uint32_t id_offset;         // Relative to the document strings
+        uint32_t id_length;
+        uint32_t path_offset;
+        uint32_t path_length;
+    };
+
+    // Check a term's postings, impacts and positions once, remembering the
+    // outcome; false if they are out of bounds or disagree
+    bool checkTerm(uint32_t term_id) const;
+    bool validatePostings(uint32_t term_id) const;
+
+    std::shared_ptr<const void> owner_;
+    const char* data_;
+    size_t size_;
+    const Header* header_;
+    const TermEntry* terms_;
+    const uint32_t* document_order_;
+    const DocumentEntry* documents_;
+    TermDictionary dictionary_;
+    std::string_view postings_;
+    std::string_view document_strings_;
+    std::unique_ptr<std::atomic<uint8_t>[]> term_states_;
+};
+
+#endif // INDEX_SEGMENT_HPP
\ No newline at end of file
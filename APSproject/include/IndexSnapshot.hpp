@@ -0,0 +1,84 @@
+#ifndef INDEX_SNAPSHOT_HPP
+#define INDEX_SNAPSHOT_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include "IndexSegment.hpp"
+#include "InvertedIndex.hpp"
+#include "PostingList.hpp"
+#include "PositionList.hpp"
+#include "TFIDFCalculator.hpp"
+
+// One immutable generation of the searchable index: segments, oldest
+// first, then the frozen chunks of the write buffer, which are searched as
+// segments too, followed by an in-memory index of the newest documents.
+// Document IDs are global: each part's local IDs are offset by the number
+// of documents in the parts before it. Term statistics are summed over all
+// parts, so scores do not depend on how the documents are split up.
+class IndexSnapshot {
+public:
+    using SegmentList = std::vector<std::shared_ptr<const IndexSegment>>;
+
+    // Postings of a query term within one part
+    struct TermPostings {
+        size_t part;                   // Position in the segments, then the index
+        uint32_t base;                 // Global ID of the part's first document
+        PostingList::View postings;
+        const uint8_t* impacts;        // nullptr for exact TF scoring
+        uint32_t max_term_frequency;
+        PositionList::View positions;  // Not available() if the part has none
+    };
+
+    // generation numbers the snapshots an engine publishes, in order
+    IndexSnapshot(SegmentList segments, const SegmentList& buffer_chunks, const InvertedIndex& index,
+                  uint64_t generation);
+
+    IndexSnapshot(const IndexSnapshot&) = delete;
+    IndexSnapshot& operator=(const IndexSnapshot&) = delete;
+
+    // Look a term up in every part, appending its postings part by part.
+    // Returns its IDF over the whole snapshot, or 0 if it is not indexed.
+    double lookupTerm(std::string_view term, std::vector<TermPostings>& postings) const;
+
+    // Number of parts: the segments plus the in-memory index
+    size_t getPartCount() const { return segments_.size() + 1; }
+
+    size_t getTotalDocuments() const { return total_documents_; }
+
+    uint64_t getGeneration() const { return generation_; }
+
+    // Global ID of a part's first document; getPartBase(getPartCount()) is
+    // the total number of documents
+    uint32_t getPartBase(size_t part) const {
+        return part < bases_.size() ? bases_[part] : static_cast<uint32_t>(total_documents_);
+    }
+
+    // Get the id of a document by global ID
+    std::string_view getDocumentId(uint32_t doc_id) const;
+
+    // Check whether any part holds a document id
+    bool containsDocument(std::string_view id) const;
+
+    // Whether queries score with quantized impacts where parts store them
+    bool hasImpacts() const { return index_.hasImpacts(); }
+
+    // The segments followed by the buffer chunks
+    const SegmentList& getSegments() const { return segments_; }
+    size_t getBufferChunkCount() const { return buffer_chunk_count_; }
+    const InvertedIndex& getIndex() const { return index_; }
+    const TFIDFCalculator& getCalculator() const { return tfidf_; }
+
+private:
+    SegmentList segments_;
+    size_t buffer_chunk_count_;
+    std::vector<uint32_t> bases_;      // First global ID of each part
+    InvertedIndex index_;
+    TFIDFCalculator tfidf_;
+    size_t total_documents_;
+    double log_total_documents_;
+    uint64_t generation_;
+};
+
+#endif // INDEX_SNAPSHOT_HPP
\ No newline at end of file
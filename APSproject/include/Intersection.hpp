@@ -0,0 +1,28 @@
+#ifndef INTERSECTION_HPP
+#define INTERSECTION_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// Intersection of sorted, duplicate-free uint32_t arrays. Arrays of similar
+// length are merged four values at a time with SSE2 all-pairs comparisons;
+// a much shorter array gallops through the longer one instead, so the cost
+// follows the shorter array rather than the sum of both.
+class Intersection {
+public:
+    // Length ratio from which intersect() gallops instead of merging
+    static constexpr size_t kGallopRatio = 32;
+
+    // Write the values in both a and b to out, which must not overlap them,
+    // and return their count
+    static size_t intersect(const uint32_t* a, size_t a_size, const uint32_t* b, size_t b_size, uint32_t* out);
+
+    // Find each value of small in large with exponential then binary search
+    static size_t gallop(const uint32_t* small, size_t small_size, const uint32_t* large, size_t large_size,
+                         uint32_t* out);
+
+    // Linear merge; SIMD when the CPU supports it
+    static size_t merge(const uint32_t* a, size_t a_size, const uint32_t* b, size_t b_size, uint32_t* out);
+};
+
+#endif // INTERSECTION_HPP
\ No newline at end of file
@@ -2,38 +2,163 @@
 #define INVERTED_INDEX_HPP
 
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
+#include <deque>
 #include <memory>
+#include <cstdint>
+#include <limits>
 #include "Document.hpp"
+#include "PostingList.hpp"
+#include "PositionList.hpp"
 
 class InvertedIndex {
 public:
-    // Structure to store document frequency information
-    struct PostingInfo {
-        std::string doc_id;
-        size_t term_frequency;
-        
-        PostingInfo(const std::string& id, size_t freq) 
-            : doc_id(id), term_frequency(freq) {}
+    // Returned by lookups for unknown terms and documents
+    static constexpr uint32_t kInvalidId = std::numeric_limits<uint32_t>::max();
+
+    using Posting = PostingList::Posting;
+
+    // Document table entry, addressed by dense document ID
+    struct DocumentEntry {
+        std::string id;
+        std::string path;
     };
-    
-    // Add a document to the index
-    void addDocument(const std::shared_ptr<Document>& doc);
-    
-    // Get posting list for a term
-    const std::vector<PostingInfo>& getPostings(const std::string& term) const;
-    
+
+    // Postings for a run of documents built off the main index, e.g. by one
+    // ingestion thread. Document IDs are local to the partial index.
+    struct PartialIndex {
+        std::vector<DocumentEntry> documents;
+        std::unordered_map<std::string, std::vector<Posting>> postings;
+
+        // If store_positions is set, the token positions of each term's
+        // postings, concatenated in posting order
+        bool store_positions{false};
+        std::unordered_map<std::string, std::vector<uint32_t>> positions;
+
+        // Append a parsed document. Throws std::invalid_argument if positions
+        // are stored and the document was parsed without them.
+        void addDocument(const Document& doc);
+    };
+
+    InvertedIndex() = default;
+
+    // The term lookup map holds views into terms_, so copies rebuild it.
+    // Copies share posting lists until either side appends to one, so a
+    // copy costs O(terms + documents) rather than O(postings).
+    InvertedIndex(const InvertedIndex& other);
+    InvertedIndex& operator=(const InvertedIndex& other);
+    InvertedIndex(InvertedIndex&&) = default;
+    InvertedIndex& operator=(InvertedIndex&&) = default;
+
+    // Add a document to the index and return its dense document ID.
+    // Throws std::invalid_argument if the document id is already indexed,
+    // or if the index stores positions and the document was parsed without
+    // them.
+    uint32_t addDocument(const std::shared_ptr<Document>& doc);
+
+    // Append a partial index; its documents get the next dense IDs in order.
+    // Throws std::invalid_argument, leaving the index unchanged, if any of
+    // its document ids is already indexed, or if the index stores positions
+    // and the partial index does not.
+    void mergePartial(const PartialIndex& partial);
+
+    // Get the dense ID of a term, or kInvalidId if it is not indexed
+    uint32_t getTermId(std::string_view term) const;
+
+    // Get the term spelled by a dense term ID
+    const std::string& getTerm(uint32_t term_id) const { return terms_[term_id]; }
+
+    // Get the block-compressed posting list for a term, sorted by document ID
+    const PostingList& getPostings(uint32_t term_id) const { return postings_[term_id]->postings; }
+    const PostingList& getPostings(const std::string& term) const;
+
+    // Get the largest term frequency on a term's posting list
+    uint32_t getMaxTermFrequency(uint32_t term_id) const {
+        return postings_[term_id]->postings.getMaxTermFrequency();
+    }
+
     // Get document frequency (number of documents containing the term)
     size_t getDocumentFrequency(const std::string& term) const;
-    
+
+    // Cached log(N) and per-term log(df). Only the terms of an added document
+    // change df, so IDF = log(N) - log(df) is refreshed incrementally.
+    double getLogTotalDocuments() const { return log_total_documents_; }
+    double getLogDocumentFrequency(uint32_t term_id) const { return log_document_frequencies_[term_id]; }
+
+    // Optionally store a quantized TF impact (TFIDFCalculator::quantizeTF)
+    // alongside every posting. Enabling builds impacts for existing postings.
+    void setStoreImpacts(bool enabled);
+    bool hasImpacts() const { return store_impacts_; }
+
+    // Get the impacts of a term's postings, parallel to getPostings(term_id)
+    const std::vector<uint8_t>& getImpacts(uint32_t term_id) const { return postings_[term_id]->impacts; }
+
+    // Optionally store the token positions of every posting, for phrase and
+    // proximity matching. Positions cannot be rebuilt from postings, so they
+    // can only be enabled on an empty index (std::logic_error otherwise);
+    // disabling drops them.
+    void setStorePositions(bool enabled);
+    bool hasPositions() const { return store_positions_; }
+
+    // Get the positions of a term's postings, parallel to getPostings(term_id)
+    const PositionList& getPositions(uint32_t term_id) const { return postings_[term_id]->positions; }
+
+    // Look up a document table entry by dense document ID
+    const DocumentEntry& getDocument(uint32_t doc_id) const { return documents_[doc_id]; }
+
+    // Check whether a document id has been indexed
+    bool containsDocument(const std::string& id) const;
+
     // Get total number of documents in the index
-    size_t getTotalDocuments() const { return total_documents_; }
-    
+    size_t getTotalDocuments() const { return documents_.size(); }
+
+    // Get number of distinct terms in the index
+    size_t getTermCount() const { return terms_.size(); }
+
 private:
-    // Map from term to its posting list
-    std::unordered_map<std::string, std::vector<PostingInfo>> index_;
-    size_t total_documents_{0};
+    // Term dictionary. Each spelling is stored once in terms_ (a deque, so
+    // addresses stay stable) and the lookup map is keyed by views into it.
+    std::deque<std::string> terms_;
+    std::unordered_map<std::string_view, uint32_t> term_ids_;
+
+    // Postings of one term with their optional impacts and positions.
+    // Shared between copies of the index and cloned before a shared list is
+    // modified.
+    struct TermPostings {
+        PostingList postings;
+        std::vector<uint8_t> impacts;
+        PositionList positions;
+    };
+
+    // Posting lists indexed by term ID
+    std::vector<std::shared_ptr<TermPostings>> postings_;
+
+    // Cached IDF ingredients
+    std::vector<double> log_document_frequencies_;
+    double log_total_documents_{0.0};
+
+    // Whether TermPostings::impacts and TermPostings::positions are maintained
+    bool store_impacts_{false};
+    bool store_positions_{false};
+
+    // Document table and its reverse lookup
+    std::vector<DocumentEntry> documents_;
+    std::unordered_map<std::string, uint32_t> document_ids_;
+
+    // Get the ID of a term, adding it to the dictionary if needed
+    uint32_t addTerm(std::string_view term);
+
+    // Register a document in the document table and return its dense ID
+    uint32_t addDocumentEntry(const DocumentEntry& entry);
+
+    // Get a term's postings for modification, cloning them if shared
+    TermPostings& mutablePostings(uint32_t term_id);
+
+    // Append a posting and keep the term's cached statistics current.
+    // positions holds the posting's term_frequency positions if stored.
+    void appendPosting(uint32_t term_id, const Posting& posting, const uint32_t* positions);
 };
 
-#endif // INVERTED_INDEX_HPP 
\ No newline at end of file
+#endif // INVERTED_INDEX_HPP
\ No newline at end of file
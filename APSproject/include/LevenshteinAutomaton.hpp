@@ -0,0 +1,49 @@
+#ifndef LEVENSHTEIN_AUTOMATON_HPP
+#define LEVENSHTEIN_AUTOMATON_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Automaton accepting the strings within an edit distance of a word. It is
+// simulated one row of the edit distance table per input byte: entry j of
+// a state is the distance between the input so far and the first j bytes
+// of the word, capped at max_distance + 1. Walking it in lockstep with a
+// trie or term dictionary visits only prefixes that can still match, since
+// once every entry exceeds the limit no extension can match.
+//
+// Meets the automaton interface of TermDictionary::intersect.
+class LevenshteinAutomaton {
+public:
+    using State = std::vector<uint8_t>;
+
+    // Throws std::invalid_argument if max_distance is 255 or more
+    LevenshteinAutomaton(std::string_view word, size_t max_distance);
+
+    State start() const;
+    State step(const State& state, unsigned char c) const;
+
+    // Step without allocating; next may not alias state
+    void step(const State& state, unsigned char c, State& next) const;
+
+    // Distance between the input and the word, or max_distance + 1 if over
+    size_t distance(const State& state) const { return state.back(); }
+
+    // Lower bound on the distance of any extension of the input to the word
+    // or to one of its prefixes
+    size_t lowestDistance(const State& state) const;
+
+    bool isMatch(const State& state) const { return distance(state) <= max_distance_; }
+    bool canMatch(const State& state) const { return lowestDistance(state) <= max_distance_; }
+
+    size_t getMaxDistance() const { return max_distance_; }
+    size_t getWordLength() const { return word_.size(); }
+
+private:
+    std::string word_;
+    size_t max_distance_;
+};
+
+#endif // LEVENSHTEIN_AUTOMATON_HPP
\ No newline at end of file
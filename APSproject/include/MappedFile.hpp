@@ -0,0 +1,55 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Read-only memory mapping of a whole file. The bytes stay valid until the
+// file is closed or the object destroyed; moving transfers the mapping.
+class MappedFile {
+public:
+    // How the caller will read the mapping, passed to the OS as a hint
+    enum class Access {
+        Normal,        // No hint
+        Sequential,    // One front-to-back pass: read ahead aggressively
+        Random         // Scattered lookups: skip read-ahead
+    };
+    
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Map a file, replacing any current mapping. Returns false if the file
+    // cannot be opened or mapped. Empty files open with a null data pointer.
+    bool open(const std::string& path, Access access = Access::Normal);
+
+    // Change the hint for an open mapping. Windows only takes the hint at
+    // open, so this does nothing there.
+    void advise(Access access);
+
+    // Release the mapping
+    void close();
+
+    bool isOpen() const { return open_; }
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    std::string_view view() const { return {data_, size_}; }
+
+private:
+    const char* data_{nullptr};
+    size_t size_{0};
+    bool open_{false};
+#ifdef _WIN32
+    void* file_handle_{nullptr};
+    void* mapping_handle_{nullptr};
+#endif
+
+    void swap(MappedFile& other) noexcept;
+};
+
+#endif // MAPPED_FILE_HPP
\ No newline at end of file
@@ -0,0 +1,47 @@
+#ifndef POSITION_LIST_HPP
+#define POSITION_LIST_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Token positions of a term's postings, parallel to its PostingList. Each
+// posting's positions are StreamVByte-coded gaps; an offset array locates
+// every posting's run, so the positions of one posting are decoded on
+// their own and only for documents that survive document-level matching.
+class PositionList {
+public:
+    // Non-owning view of a position list's storage
+    struct View {
+        const uint32_t* offsets{nullptr};  // size + 1 byte offsets into data
+        const uint8_t* data{nullptr};
+        const uint8_t* data_end{nullptr};
+        size_t size{0};                    // Number of postings
+
+        // Whether the view refers to stored positions
+        bool available() const { return offsets != nullptr; }
+
+        // Decode the count positions (the posting's term frequency) of the
+        // index-th posting. Throws std::runtime_error if its run is out of
+        // bounds.
+        void decode(size_t index, size_t count, uint32_t* positions) const;
+    };
+
+    // Append the increasing positions of the next posting
+    void append(const uint32_t* positions, size_t count);
+
+    // Number of postings whose positions are stored
+    size_t size() const { return offsets_.size() - 1; }
+
+    // Bytes used by the offsets and the encoded positions
+    size_t memoryUsage() const;
+
+    // View over the list's current contents
+    View view() const;
+
+private:
+    std::vector<uint32_t> offsets_{0};
+    std::vector<uint8_t> data_;
+};
+
+#endif // POSITION_LIST_HPP
\ No newline at end of file
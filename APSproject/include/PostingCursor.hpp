@@ -0,0 +1,74 @@
+#ifndef POSTING_CURSOR_HPP
+#define POSTING_CURSOR_HPP
+
+#include <cstdint>
+#include <vector>
+#include "InvertedIndex.hpp"
+#include "PostingList.hpp"
+
+// Forward iterator over one block-compressed posting list with block-max
+// skipping. Doc IDs are decoded a block at a time when the cursor enters a
+// block; term frequencies only when first requested. The cursor keeps two
+// positions: the current posting, and a "shallow" block that can be moved
+// ahead without decoding so callers can inspect score upper bounds before
+// paying for a real advance.
+class PostingCursor {
+public:
+    // Document ID reported once the cursor is exhausted
+    static constexpr uint32_t kEnd = InvertedIndex::kInvalidId;
+
+    // impacts, when given, runs parallel to the list (InvertedIndex::getImpacts)
+    explicit PostingCursor(const PostingList::View& list, const uint8_t* impacts = nullptr);
+
+    // Current posting
+    uint32_t docId() const { return doc_id_; }
+    uint32_t termFrequency();
+    uint8_t impact() const { return impacts_[block_ * PostingList::kBlockSize + pos_]; }
+
+    // Index of the current posting on the list, e.g. into its positions
+    size_t index() const { return block_ * PostingList::kBlockSize + pos_; }
+
+    // Check whether the cursor carries quantized impacts
+    bool hasImpacts() const { return impacts_ != nullptr; }
+
+    // Move to the next posting
+    void next() {
+        if (++pos_ < count_) {
+            doc_id_ = doc_ids_[pos_];
+        }
+        else {
+            loadBlock(block_ + 1);
+        }
+    }
+
+    // Move to the first posting whose document ID is >= target
+    void nextGEQ(uint32_t target);
+
+    // Move the shallow block to the first block that may contain target
+    void shallowAdvance(uint32_t target);
+
+    // Metadata of the shallow block; kEnd / 0 once past the last block
+    uint32_t blockLastDocId() const;
+    uint32_t blockMaxTermFrequency() const;
+
+    // Number of postings on the list
+    size_t size() const { return list_.size; }
+
+private:
+    PostingList::View list_;
+    const uint8_t* impacts_;
+
+    size_t block_{0};          // Block currently decoded
+    size_t shallow_block_{0};  // Block inspected by the block-max accessors
+    size_t pos_{0};
+    size_t count_{0};
+    uint32_t doc_id_{kEnd};
+    bool term_frequencies_decoded_{false};
+    uint32_t doc_ids_[PostingList::kBlockSize];
+    uint32_t term_frequencies_[PostingList::kBlockSize];
+
+    // Decode block b's doc IDs and position on its first posting
+    void loadBlock(size_t b);
+};
+
+#endif // POSTING_CURSOR_HPP 
\ No newline at end of file
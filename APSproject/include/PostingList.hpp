@@ -0,0 +1,88 @@
+#ifndef POSTING_LIST_HPP
+#define POSTING_LIST_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Block-compressed posting list. Postings are grouped into blocks of
+// kBlockSize; each full block stores its doc IDs as StreamVByte-coded gaps
+// and its term frequencies as StreamVByte-coded values. Postings of the
+// last, still-filling block stay uncompressed until the block is full.
+class PostingList {
+public:
+    // Number of postings per compressed block
+    static constexpr size_t kBlockSize = 128;
+
+    // Packed posting: dense document ID plus term frequency
+    struct Posting {
+        uint32_t doc_id;
+        uint32_t term_frequency;
+    };
+
+    // Per-block metadata. last_doc_id doubles as the skip key, and TF-IDF is
+    // monotone in tf, so max_term_frequency bounds every score in the block
+    // once multiplied by the term's current IDF. Offsets locate the encoded
+    // doc-gap and tf streams in the list's data.
+    struct BlockInfo {
+        uint32_t last_doc_id;
+        uint32_t max_term_frequency;
+        uint32_t doc_offset;
+        uint32_t tf_offset;
+    };
+
+    // Non-owning view of a posting list's storage. Views can point into a
+    // PostingList or into any other buffer holding the same layout.
+    struct View {
+        const BlockInfo* blocks{nullptr};
+        size_t num_blocks{0};          // Including the uncompressed tail block
+        const uint8_t* data{nullptr};  // Encoded bytes of the compressed blocks
+        const uint8_t* data_end{nullptr};
+        const Posting* tail{nullptr};  // Postings of an uncompressed last block
+        size_t tail_size{0};
+        size_t size{0};                // Total number of postings
+
+        // Number of postings in block b
+        size_t blockSize(size_t b) const {
+            return b + 1 < num_blocks ? kBlockSize : size - b * kBlockSize;
+        }
+
+        // Decode the doc IDs / term frequencies of block b; return the count
+        size_t decodeDocIds(size_t b, uint32_t* doc_ids) const;
+        size_t decodeTermFrequencies(size_t b, uint32_t* term_frequencies) const;
+    };
+
+    // Append a posting; doc IDs must be strictly increasing
+    void append(const Posting& posting);
+
+    // Number of postings on the list
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    // Largest term frequency on the list
+    uint32_t getMaxTermFrequency() const { return max_term_frequency_; }
+
+    // Block metadata, including an entry for the uncompressed tail block
+    const std::vector<BlockInfo>& getBlocks() const { return blocks_; }
+
+    // Bytes used by compressed data, block metadata and the tail
+    size_t memoryUsage() const;
+
+    // View over the list's current contents
+    View view() const;
+
+    // Decode every posting (for tests and bulk operations)
+    std::vector<Posting> decode() const;
+
+private:
+    std::vector<BlockInfo> blocks_;
+    std::vector<uint8_t> data_;
+    std::vector<Posting> tail_;
+    size_t size_{0};
+    uint32_t max_term_frequency_{0};
+
+    // Compress the full tail into a block
+    void sealTail();
+};
+
+#endif // POSTING_LIST_HPP
\ No newline at end of file
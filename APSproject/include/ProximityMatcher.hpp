@@ -0,0 +1,27 @@
+#ifndef PROXIMITY_MATCHER_HPP
+#define PROXIMITY_MATCHER_HPP
+
+#include <cstdint>
+#include <vector>
+#include "PositionList.hpp"
+#include "PostingCursor.hpp"
+#include "Query.hpp"
+
+// Positional intersection for phrase and NEAR constraints. Posting lists
+// are first intersected on document ID, leapfrogging from the rarest list
+// with skipping cursors; positions are only decoded for documents holding
+// every term, and then merged to look for an occurrence.
+class ProximityMatcher {
+public:
+    // One constraint term: its postings and their positions in one part
+    struct Term {
+        PostingCursor cursor;
+        PositionList::View positions;
+    };
+
+    // Return the document IDs, ascending, where the terms (parallel to
+    // constraint.terms) satisfy the constraint
+    static std::vector<uint32_t> match(std::vector<Term> terms, const Query::Proximity& constraint);
+};
+
+#endif // PROXIMITY_MATCHER_HPP
\ No newline at end of file
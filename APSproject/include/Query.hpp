@@ -0,0 +1,72 @@
+#ifndef QUERY_HPP
+#define QUERY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A parsed search query. From loosest to tightest binding:
+//   a OR b          documents matching either side
+//   a AND b         documents matching both sides
+//   a b             juxtaposition: phrase and NEAR operands are required
+//                   and the others only rank; without any, either matches
+//   NOT a           documents not matching a
+//   "a b"           terms at consecutive positions, in order
+//   a NEAR/k b      two terms at most k positions apart, in either order
+//   (a)             grouping
+// Operators are upper case; lower-case "and", "or", "not" and "near" are
+// plain terms. Terms follow the Tokenizer rules, and an operator missing an
+// operand is ignored. A NEAR operand next to a phrase is the phrase's
+// adjacent term. A query nesting groups and NOT operators more than
+// kMaxDepth deep parses as an empty query, which matches nothing.
+struct Query {
+    static constexpr size_t kMaxDepth = 64;
+
+    // Positional constraint over index terms
+    struct Proximity {
+        enum class Kind {
+            Phrase,     // Terms at consecutive positions, in order
+            Near        // Two terms at most distance positions apart, in either order
+        };
+
+        Kind kind;
+        std::vector<std::string> terms;
+        uint32_t distance;
+    };
+
+    // Node of the match expression
+    struct Node {
+        enum class Kind {
+            Term,       // Documents containing term
+            Proximity,  // Documents satisfying proximity
+            And,        // Documents matching every child
+            Or,         // Documents matching any child
+            Not         // Documents not matching the only child
+        };
+
+        Kind kind;
+        std::string term;
+        Proximity proximity;
+        std::vector<Node> children;
+    };
+
+    // Terms that rank the matching documents, in query order; negated terms
+    // are left out
+    std::vector<std::string> terms;
+
+    // Which documents match. Empty for a plain list of terms, where every
+    // document containing one of them does.
+    std::optional<Node> filter;
+
+    // Parse query text
+    static Query parse(std::string_view text);
+
+    // Canonical text of the parsed query: queries with the same text match
+    // and rank the same documents
+    std::string normalized() const;
+};
+
+#endif // QUERY_HPP
\ No newline at end of file
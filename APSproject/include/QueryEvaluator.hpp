@@ -0,0 +1,42 @@
+#ifndef QUERY_EVALUATOR_HPP
+#define QUERY_EVALUATOR_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "IndexSnapshot.hpp"
+#include "Query.hpp"
+
+// Computes the documents matching a query's match expression over one index
+// snapshot. A conjunction starts from its rarest operand and narrows the
+// candidates down with the other operands, rarest first. Against a term's
+// compressed postings, candidates that are much sparser than the list skip
+// through it with the block index; otherwise each block holding candidates
+// is decoded and intersected with them by Intersection's SIMD merge.
+// Phrase and NEAR constraints are matched with ProximityMatcher.
+class QueryEvaluator {
+public:
+    explicit QueryEvaluator(const IndexSnapshot& snapshot) : snapshot_(snapshot) {}
+
+    // Global IDs, ascending, of the documents matching node
+    std::vector<uint32_t> evaluate(const Query::Node& node) const;
+
+private:
+    const IndexSnapshot& snapshot_;
+
+    std::vector<uint32_t> evaluateAnd(const Query::Node& node) const;
+    std::vector<uint32_t> evaluateOr(const Query::Node& node) const;
+
+    // Documents on a term's postings, or satisfying a positional constraint
+    std::vector<uint32_t> termDocuments(const std::vector<IndexSnapshot::TermPostings>& postings) const;
+    std::vector<uint32_t> proximityDocuments(const Query::Proximity& proximity) const;
+
+    // Documents of the snapshot that are not in documents
+    std::vector<uint32_t> complement(const std::vector<uint32_t>& documents) const;
+
+    // Keep the candidates that are on a term's postings
+    std::vector<uint32_t> intersectPostings(const std::vector<uint32_t>& candidates,
+                                            const std::vector<IndexSnapshot::TermPostings>& postings) const;
+};
+
+#endif // QUERY_EVALUATOR_HPP
\ No newline at end of file
@@ -0,0 +1,80 @@
+#ifndef QUERY_LOG_HPP
+#define QUERY_LOG_HPP
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Aggregates query terms into time-decayed popularity scores off the query
+// path. Query threads only add to one of kShards counter tables, picked by
+// thread. A background thread drains the tables every interval, decays the
+// scores so that they halve every half-life, and hands the terms whose
+// rounded score changed to a publisher. At most max_terms scores are
+// tracked; the lowest are dropped first.
+class QueryLog {
+public:
+    // Receives (term, popularity) pairs; a dropped term is published as 0
+    using Publisher = std::function<void(const std::vector<std::pair<std::string, size_t>>& changes)>;
+
+    static constexpr size_t kShards = 16;
+
+    QueryLog(Publisher publisher, std::chrono::milliseconds interval, std::chrono::milliseconds half_life,
+             size_t max_terms);
+
+    // Stop the background thread; counts not yet aggregated are discarded
+    ~QueryLog();
+
+    QueryLog(const QueryLog&) = delete;
+    QueryLog& operator=(const QueryLog&) = delete;
+
+    // Count one query's terms
+    void record(const std::vector<std::string>& terms);
+
+    // Aggregate and publish now instead of at the next interval
+    void flush();
+
+    // Publish every tracked score again on the next aggregation, for a
+    // consumer whose state was replaced
+    void republish();
+
+private:
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<std::string, size_t> counts;
+    };
+
+    struct Score {
+        double value;
+        size_t published;
+    };
+
+    std::array<Shard, kShards> shards_;
+    Publisher publisher_;
+    std::chrono::milliseconds interval_;
+    double decay_rate_;     // Per second
+    size_t max_terms_;
+
+    // Aggregated scores, guarded by aggregate_mutex_, which is also held
+    // while publishing so that publications arrive in order
+    std::mutex aggregate_mutex_;
+    std::unordered_map<std::string, Score> scores_;
+    std::chrono::steady_clock::time_point last_aggregation_;
+
+    std::mutex worker_mutex_;
+    std::condition_variable wake_;
+    bool stopping_{false};
+    std::thread worker_;
+
+    void aggregate();
+    void workerLoop();
+};
+
+#endif // QUERY_LOG_HPP
\ No newline at end of file
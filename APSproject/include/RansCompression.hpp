@@ -0,0 +1,34 @@
+#ifndef RANS_COMPRESSION_HPP
+#define RANS_COMPRESSION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Codec.hpp"
+
+// Byte-level range asymmetric numeral system (rANS) coder with a static
+// model. Symbol probabilities are quantized to kScaleBits bits rather than
+// rounded to powers of two as Huffman code lengths are, so skewed data
+// compresses closer to its entropy. Two interleaved states let decoding
+// overlap consecutive symbols; each step is one table lookup plus a
+// multiply.
+//
+// Stream layout: uint64_t original size, a 256-bit bitmap of the bytes that
+// occur, their uint16_t frequencies (all little-endian), the two final
+// encoder states, then the 16-bit renormalization words in decoding order.
+class RansCompression : public Codec {
+public:
+    static constexpr int kScaleBits = 12;
+
+    Id id() const override { return Id::Rans; }
+
+    std::vector<unsigned char> compress(const char* data, size_t size) const override;
+
+    void decompress(const unsigned char* data, size_t size, char* out, size_t out_size) const override;
+
+    // The declared size: a stream of one repeated byte needs no
+    // renormalization words, so the length alone bounds nothing
+    uint64_t maxDecodedSize(const unsigned char* data, size_t size) const override;
+};
+
+#endif // RANS_COMPRESSION_HPP
\ No newline at end of file
@@ -0,0 +1,80 @@
+#ifndef RESULT_CACHE_HPP
+#define RESULT_CACHE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Concurrent LRU cache of search results. Keys hash to one of kShards
+// shards, each an LRU list under its own mutex, so concurrent queries
+// rarely contend. Every entry records the index generation it was computed
+// against: a lookup for a newer generation misses and drops the entry, so
+// results never outlive the index contents they came from.
+class ResultCache {
+public:
+    using Results = std::vector<std::pair<std::string, double>>;
+
+    static constexpr size_t kShards = 16;
+
+    struct Stats {
+        uint64_t hits;
+        uint64_t misses;
+        size_t entries;
+    };
+
+    // Keep up to capacity result lists, split evenly across the shards;
+    // 0 disables the cache
+    explicit ResultCache(size_t capacity);
+
+    // Get the results cached for key at generation, or nullptr
+    std::shared_ptr<const Results> lookup(const std::string& key, uint64_t generation);
+
+    // Cache results for key at generation, evicting the least recently used
+    // entry of its shard if it is full
+    void insert(const std::string& key, uint64_t generation, Results results);
+
+    // Change the capacity, evicting entries that no longer fit
+    void setCapacity(size_t capacity);
+    size_t getCapacity() const { return capacity_.load(std::memory_order_relaxed); }
+
+    // Hit and miss counts since construction, and the current entry count
+    Stats getStats() const;
+
+private:
+    struct Entry {
+        std::string key;
+        uint64_t generation;
+        std::shared_ptr<const Results> results;
+    };
+
+    // The map is keyed by views into the keys of the list's entries
+    struct Shard {
+        mutable std::mutex mutex;
+        std::list<Entry> entries;      // Most recently used first
+        std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+    };
+
+    std::array<Shard, kShards> shards_;
+    std::atomic<size_t> capacity_;
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+
+    Shard& shardFor(const std::string& key);
+
+    // Entries one shard may hold
+    size_t shardCapacity() const { return (getCapacity() + kShards - 1) / kShards; }
+
+    // Drop least recently used entries beyond limit. Requires the shard's mutex.
+    static void evict(Shard& shard, size_t limit);
+};
+
+#endif // RESULT_CACHE_HPP
\ No newline at end of file
@@ -0,0 +1,39 @@
+#ifndef SCORE_ACCUMULATOR_HPP
+#define SCORE_ACCUMULATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Dense per-document score array for term-at-a-time query evaluation.
+// Slots are stamped with the query generation, so starting a new query
+// costs O(1) instead of clearing one slot per indexed document.
+class ScoreAccumulator {
+public:
+    // Prepare for a new query over documents [0, num_documents)
+    void reset(size_t num_documents);
+
+    // Add a partial score for a document
+    void add(uint32_t doc_id, double score) {
+        if (stamps_[doc_id] != generation_) {
+            stamps_[doc_id] = generation_;
+            scores_[doc_id] = 0.0;
+            touched_.push_back(doc_id);
+        }
+        scores_[doc_id] += score;
+    }
+
+    // Get the accumulated score of a document touched by the current query
+    double getScore(uint32_t doc_id) const { return scores_[doc_id]; }
+
+    // Documents that received at least one partial score, in first-touch order
+    const std::vector<uint32_t>& getTouched() const { return touched_; }
+
+private:
+    std::vector<double> scores_;
+    std::vector<uint32_t> stamps_;   // Generation that last wrote each slot
+    std::vector<uint32_t> touched_;
+    uint32_t generation_{0};
+};
+
+#endif // SCORE_ACCUMULATOR_HPP
\ No newline at end of file
@@ -5,51 +5,257 @@
 #include <vector>
 #include <memory>
 #include <utility>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <shared_mutex>
 #include "Document.hpp"
 #include "InvertedIndex.hpp"
+#include "IndexSegment.hpp"
+#include "IndexSnapshot.hpp"
 #include "TFIDFCalculator.hpp"
-#include "HuffmanCompression.hpp"
 #include "Trie.hpp"
 #include "SpellCorrector.hpp"
+#include "ScoreAccumulator.hpp"
+#include "BlockMaxWand.hpp"
+#include "Query.hpp"
+#include "SearchResultIterator.hpp"
+#include "ThreadPool.hpp"
+#include "EpochManager.hpp"
+#include "ResultCache.hpp"
+#include "QueryLog.hpp"
 
+// Queries may run concurrently with each other and with document ingestion.
+// Writers are serialized and publish immutable index snapshots; queries pin
+// the current snapshot without locking, and replaced snapshots are freed by
+// epoch-based reclamation once no query uses them.
+//
+// The index is log-structured: new documents go to an in-memory write
+// buffer, which is frozen into an immutable segment once it is full, and a
+// background thread merges segments of similar size. Queries search the
+// segments and the buffer together. A loaded index file is not read into
+// memory: its segments are mapped and queried in place.
 class SearchEngine {
 public:
-    SearchEngine();
+    // How ranked queries are evaluated. Both strategies return the same
+    // top documents; BlockMaxWand skips documents that cannot make the cut.
+    enum class ScoringStrategy {
+        TermAtATime,    // Score every posting of every query term
+        BlockMaxWand    // Top-k retrieval with block-max dynamic pruning
+    };
+    
+    // How saveIndex encodes the file
+    enum class IndexCompression {
+        None,       // Segments stay memory-mappable
+        Huffman,    // Blocks coded in parallel with HuffmanCompression
+        Rans        // Blocks coded with RansCompression: smaller files
+    };
+    
+    // Create an engine whose bulk operations use num_threads workers
+    explicit SearchEngine(size_t num_threads = std::thread::hardware_concurrency());
+    ~SearchEngine();
+    
+    SearchEngine(const SearchEngine&) = delete;
+    SearchEngine& operator=(const SearchEngine&) = delete;
     
     // Add a document to the search engine
     void addDocument(const std::string& id, const std::string& path);
     
-    // Search for documents matching the query
+    // Add a batch of (id, path) documents. Files are parsed in parallel into
+    // per-thread partial indexes, which are then merged into the index,
+    // autocomplete and spelling dictionaries in one pass. Either the whole
+    // batch is added or, if an id is taken or a file fails to parse, an
+    // exception is thrown and nothing is added.
+    void addDocuments(const std::vector<std::pair<std::string, std::string>>& documents);
+    
+    // Freeze the write buffer into a segment once it holds this many
+    // documents (at least 1). Smaller buffers produce more segments for the
+    // background merge.
+    void setFlushThreshold(size_t documents);
+    size_t getFlushThreshold() const;
+    
+    // Freeze the documents buffered so far into a segment
+    void flush();
+    
+    // Wait until no background merge is running or scheduled
+    void waitForMerges();
+    
+    // Number of immutable segments searched besides the write buffer
+    size_t getSegmentCount() const;
+    
+    // Search for documents matching the query. Plain terms match documents
+    // containing any of them; AND, OR, NOT, parentheses, quoted phrases and
+    // NEAR/k operators narrow the matches down (see Query).
     std::vector<std::pair<std::string, double>> search(const std::string& query, size_t num_results = 10) const;
     
-    // Get autocomplete suggestions
+    // Search lazily: results are pulled best first, without a result limit.
+    // They are selected in batches of growing size, so candidates beyond
+    // those requested are neither kept nor sorted. The iterator must not
+    // outlive the engine.
+    SearchResultIterator searchIterator(const std::string& query) const;
+    
+    // Get autocomplete suggestions, ranked by document frequency plus the
+    // decayed number of queries for each word. Queries are counted in the
+    // background, so they affect suggestions about a second later.
     std::vector<std::string> getAutocompleteSuggestions(const std::string& prefix) const;
     
+    // Autocomplete a prefix that may contain typos: completions of anything
+    // within max_distance edits of it, closest first, then as above
+    std::vector<std::string> getFuzzyAutocompleteSuggestions(const std::string& prefix,
+                                                             size_t max_distance = 1) const;
+    
+    // Apply the queries counted so far to autocomplete right away
+    void flushQueryLog();
+    
     // Get spell correction suggestions
     std::vector<std::string> getSpellingSuggestions(const std::string& word) const;
     
-    // Compress and save index to file
-    bool saveIndex(const std::string& filename) const;
+    // Save the index, autocomplete and spelling data to a versioned binary
+    // file. The file is written under a temporary name and then renamed, so
+    // an interrupted save leaves any previous file intact. Compressed files
+    // are smaller but are decoded into memory when loaded.
+    bool saveIndex(const std::string& filename, IndexCompression compression = IndexCompression::None) const;
     
-    // Load compressed index from file
+    // Load a file written by saveIndex, replacing the engine's contents.
+    // Uncompressed index segments are memory-mapped and used in place, and
+    // source documents are not read again. Returns false, leaving the
+    // engine unchanged, if the file is missing, damaged or of another
+    // version.
     bool loadIndex(const std::string& filename);
     
     // Get total number of documents
-    size_t getDocumentCount() const { return index_.getTotalDocuments(); }
+    size_t getDocumentCount() const;
+    
+    // Select how search() evaluates queries
+    void setScoringStrategy(ScoringStrategy strategy) { scoring_strategy_.store(strategy); }
+    ScoringStrategy getScoringStrategy() const { return scoring_strategy_.load(); }
+    
+    // Score with 8-bit quantized TF impacts precomputed at index time instead
+    // of exact TF weights. Trades a small score error for smaller, faster
+    // inner loops. Enabling quantizes the buffered postings once; segments
+    // written without impacts quantize their TF while scoring, so every
+    // part of the index scores the same way.
+    void setImpactScoring(bool enabled);
+    bool getImpactScoring() const;
+    
+    // Store token positions, which phrase and NEAR queries need: documents
+    // indexed without positions never match them. Enabled by default.
+    // Changing it freezes the buffered documents into a segment first, as
+    // positions cannot be added to documents already indexed.
+    void setPositionIndexing(bool enabled);
+    bool getPositionIndexing() const;
+    
+    // Results of search() are cached by normalized query and result count
+    // until the next change to the index is published. A capacity of zero
+    // disables the cache.
+    void setResultCacheCapacity(size_t entries);
+    size_t getResultCacheCapacity() const;
+    ResultCache::Stats getResultCacheStats() const;
     
 private:
+    // Writer-side state, modified under write_mutex_ and copied on publish:
+    // immutable segments plus the write buffer of newer documents. The
+    // buffer is a few frozen chunks, shared by every snapshot, and a small
+    // index of the newest documents, which is the only part copied.
+    IndexSnapshot::SegmentList segments_;
+    IndexSnapshot::SegmentList buffer_chunks_;
     InvertedIndex index_;
-    std::unique_ptr<TFIDFCalculator> tfidf_calculator_;
-    std::vector<std::shared_ptr<Document>> documents_;
-    std::unique_ptr<HuffmanCompression> compressor_;
+    std::atomic<const IndexSnapshot*> snapshot_;
+    mutable EpochManager epochs_;
+    mutable std::mutex write_mutex_;
+    size_t flush_threshold_;
+    
+    // Generation of the latest published snapshot. Requires write_mutex_.
+    uint64_t generation_{0};
+    
+    // At most one merge runs at a time, on its own worker so that it never
+    // delays ingestion tasks
+    bool merging_{false};
+    std::condition_variable merge_finished_;
+    std::unique_ptr<ThreadPool> merge_pool_;
+    
+    // Autocomplete and spelling helpers; readers share helpers_mutex_
     std::unique_ptr<Trie> autocomplete_trie_;
     std::unique_ptr<SpellCorrector> spell_corrector_;
+    mutable std::shared_mutex helpers_mutex_;
+    
+    // Query terms, aggregated in the background into autocomplete
+    // popularity
+    mutable QueryLog query_log_;
+    
+    std::unique_ptr<ThreadPool> thread_pool_;
+    std::atomic<ScoringStrategy> scoring_strategy_{ScoringStrategy::BlockMaxWand};
+    mutable ResultCache result_cache_;
+    
+    // Replace the published snapshot with one of the segments, the buffer
+    // chunks and a copy of index_, and retire the old one. Requires
+    // write_mutex_.
+    void publishSnapshot();
+    
+    // Documents in the write buffer. Requires write_mutex_.
+    size_t getBufferedDocuments() const;
+    
+    // Flush the write buffer once it reaches the flush threshold, or else
+    // freeze index_ into a chunk once it reaches the chunk size. Requires
+    // write_mutex_.
+    void maintainWriteBuffer();
+    
+    // Freeze the buffer chunks and index_ into one new segment without
+    // publishing. Requires write_mutex_.
+    void flushWriteBuffer();
+    
+    // Freeze index_ into a buffer chunk, merging chunks to keep their count
+    // logarithmic. Requires write_mutex_.
+    void freezeBufferChunk();
+    
+    // Replace index_ with an empty index of the same settings. Requires
+    // write_mutex_.
+    void resetWriteIndex();
+    
+    // Start merging a run of similar-sized segments if the merge policy
+    // calls for one and no merge is running. Requires write_mutex_.
+    void scheduleMerge();
+    
+    // Check whether a document id is taken. Requires write_mutex_.
+    bool containsDocument(const std::string& id) const;
+    
+    // Parse a document into index_ and the helpers without publishing.
+    // Requires write_mutex_.
+    void indexDocument(const std::string& id, const std::string& path);
+    
+    // Accumulate term-at-a-time TF-IDF scores for the query terms
+    void accumulateScores(const IndexSnapshot& snapshot, const std::vector<std::string>& query_terms,
+                          ScoreAccumulator& accumulator) const;
+    
+    // Evaluate a parsed query against a pinned snapshot, best first
+    std::vector<std::pair<std::string, double>> rank(const IndexSnapshot& snapshot, const Query& parsed,
+                                                     size_t num_results) const;
+    
+    // The best num_results of a parsed query by dense document ID
+    std::vector<std::pair<uint32_t, double>> select(const IndexSnapshot& snapshot, const Query& parsed,
+                                                    size_t num_results) const;
+    
+    // Ranked retrieval over dense document IDs, best first
+    std::vector<std::pair<uint32_t, double>> scoreTermAtATime(const IndexSnapshot& snapshot,
+                                                              const std::vector<std::string>& query_terms,
+                                                              size_t num_results) const;
+    std::vector<std::pair<uint32_t, double>> scoreBlockMaxWand(const IndexSnapshot& snapshot,
+                                                               const std::vector<std::string>& query_terms,
+                                                               size_t num_results) const;
+    
+    // Score the matches of a filtered query (global IDs, ascending) by
+    // TF-IDF over the query terms; matches no term scores get 0
+    std::vector<TopKCollector::Entry> scoreMatches(const IndexSnapshot& snapshot,
+                                                   const std::vector<std::string>& query_terms,
+                                                   const std::vector<uint32_t>& matches) const;
     
-    // Helper function to tokenize query
-    std::vector<std::string> tokenizeQuery(const std::string& query) const;
+    // Apply popularity changes from query_log_ to the autocomplete trie
+    void publishPopularity(const std::vector<std::pair<std::string, size_t>>& changes);
     
-    // Helper function to update autocomplete and spell correction data
-    void updateSearchHelpers(const std::string& word);
+    // Helper function to update autocomplete and spell correction data;
+    // count is the number of new documents containing the word.
+    // Requires helpers_mutex_ held exclusively.
+    void updateSearchHelpers(const std::string& word, size_t count = 1);
 };
 
 #endif // SEARCH_ENGINE_HPP 
\ No newline at end of file
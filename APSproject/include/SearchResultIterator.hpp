@@ -0,0 +1,54 @@
+#ifndef SEARCH_RESULT_ITERATOR_HPP
+#define SEARCH_RESULT_ITERATOR_HPP
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+#include "EpochManager.hpp"
+#include "IndexSnapshot.hpp"
+#include "TopKCollector.hpp"
+
+// Pull-based, best-first view over the results of a query. Results are
+// selected in batches of growing size: the iterator asks for the best k,
+// hands them out, and asks for the best 2k once they run out. Ranking is a
+// total order (score, then document ID), so each batch extends the last.
+// A caller that stops after a few results pays for a small top-k selection,
+// which Block-Max WAND can prune, and the full candidate set is never held;
+// going through every result costs a logarithmic number of selections.
+// Boolean queries score every match anyway, so their selector scores them
+// once and keeps them, sorting only the next batch on each refill.
+// The iterator pins the index snapshot it was scored against, so it stays
+// valid while documents are added; that snapshot is not reclaimed until the
+// iterator is destroyed.
+class SearchResultIterator {
+public:
+    // Select the best k (doc_id, score) pairs, best first. Called with
+    // growing k; it may keep state between calls.
+    using Select = std::function<std::vector<TopKCollector::Entry>(size_t k)>;
+
+    SearchResultIterator(EpochManager::Guard guard, const IndexSnapshot& snapshot, Select select);
+
+    // Check whether more results remain
+    bool hasNext() const;
+
+    // Get the best remaining (document id, score) pair
+    std::pair<std::string, double> next();
+
+private:
+    EpochManager::Guard guard_;
+    const IndexSnapshot* snapshot_;
+    Select select_;
+
+    // The best batch_size_ results or fewer, of which position_ are pulled.
+    // Fetched on demand, hence mutable.
+    mutable std::vector<TopKCollector::Entry> batch_;
+    mutable size_t batch_size_{0};
+    size_t position_{0};
+
+    // Whether the last batch came back short, holding every result
+    bool exhausted() const { return batch_.size() < batch_size_; }
+};
+
+#endif // SEARCH_RESULT_ITERATOR_HPP
\ No newline at end of file
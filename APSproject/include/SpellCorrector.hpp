@@ -1,34 +1,59 @@
 #ifndef SPELL_CORRECTOR_HPP
 #define SPELL_CORRECTOR_HPP
 
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
-#include <unordered_set>
-#include <memory>
+#include "BinaryIO.hpp"
+#include "TermDictionary.hpp"
 
 class SpellCorrector {
 public:
     // Constructor with maximum edit distance
     explicit SpellCorrector(size_t max_distance = 2) : max_distance_(max_distance) {}
     
-    // Add a word to the dictionary
-    void addWord(const std::string& word);
+    // Add a word to the dictionary, found in count more documents
+    void addWord(const std::string& word, size_t count = 1);
     
-    // Get suggestions for a potentially misspelled word
+    // Get suggestions for a potentially misspelled word: the closest words
+    // first, then the most frequent
     std::vector<std::string> getSuggestions(const std::string& word) const;
     
+    // Check if a word is in the dictionary
+    bool contains(const std::string& word) const;
+    
+    // Number of distinct words
+    size_t size() const;
+    
+    // Approximate heap usage in bytes
+    size_t memoryUsage() const;
+    
     // Clear the dictionary
-    void clear() { dictionary_.clear(); }
+    void clear();
+    
+    // Write the dictionary, and read it back (replacing the current words)
+    void serialize(BinaryWriter& writer) const;
+    void deserialize(BinaryReader& reader);
     
 private:
     size_t max_distance_;
-    std::unordered_set<std::string> dictionary_;
+    
+    // Words live in an immutable automaton with their frequencies. Newer
+    // words and counts wait in pending_ until it outgrows a fraction of the
+    // dictionary, and are then merged into a new automaton.
+    TermDictionary dictionary_;
+    std::unordered_map<std::string, uint32_t> pending_;
+    
+    // The dictionary with the pending words and counts merged in
+    TermDictionary merged() const;
     
     // Calculate Levenshtein distance between two strings
-    size_t levenshteinDistance(const std::string& s1, const std::string& s2) const;
+    size_t levenshteinDistance(std::string_view s1, std::string_view s2) const;
     
     // Generate possible corrections within max_distance_
     std::vector<std::string> generateCandidates(const std::string& word) const;
 };
 
-#endif // SPELL_CORRECTOR_HPP 
\ No newline at end of file
+#endif // SPELL_CORRECTOR_HPP
\ No newline at end of file
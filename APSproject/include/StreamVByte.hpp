@@ -0,0 +1,38 @@
+#ifndef STREAM_VBYTE_HPP
+#define STREAM_VBYTE_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// StreamVByte integer codec (Lemire, Kurz & Rupp, 2017). Each value is
+// stored in 1-4 little-endian bytes; the lengths live in a separate stream
+// of 2-bit control codes, four values per control byte. Keeping controls
+// apart from data lets an SSSE3 shuffle decode four values per step.
+//
+// Layout of n values: ceil(n / 4) control bytes, then the data bytes.
+class StreamVByte {
+public:
+    // Upper bound on the encoded size of n values
+    static size_t maxEncodedSize(size_t n) { return (n + 3) / 4 + 4 * n; }
+
+    // Exact encoded size of n values, read from their control bytes
+    static size_t encodedSize(const uint8_t* in, size_t n);
+
+    // Encode n values; returns the number of bytes written
+    static size_t encode(const uint32_t* in, size_t n, uint8_t* out);
+
+    // Encode n increasing values as gaps from previous (the value before in[0])
+    static size_t encodeDelta(const uint32_t* in, size_t n, uint32_t previous, uint8_t* out);
+
+    // Decode n values; returns the number of bytes consumed. The values
+    // must lie before limit (check with encodedSize for untrusted bytes);
+    // the SIMD path reads whole 16-byte words up to limit and falls back to
+    // scalar code near it.
+    static size_t decode(const uint8_t* in, size_t n, uint32_t* out, const uint8_t* limit);
+
+    // Decode n gap-encoded values and prefix-sum them starting from previous
+    static size_t decodeDelta(const uint8_t* in, size_t n, uint32_t previous, uint32_t* out,
+                              const uint8_t* limit);
+};
+
+#endif // STREAM_VBYTE_HPP
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define TFIDF_CALCULATOR_HPP
 
 #include <cmath>
+#include <cstdint>
 #include "InvertedIndex.hpp"
 #include "Document.hpp"
 
@@ -12,13 +13,37 @@ public:
     // Calculate TF (term frequency) for a term in a document
     double calculateTF(const std::string& term, const Document& doc) const;
     
+    // Calculate TF from a raw term frequency taken from a posting. When the
+    // index scores with impacts the weight is quantized the same way, so
+    // postings stored without impacts score like those stored with them.
+    double calculateTF(size_t term_frequency) const;
+    
     // Calculate IDF (inverse document frequency) for a term
     double calculateIDF(const std::string& term) const;
     
+    // Calculate IDF from a known document frequency (posting list length)
+    double calculateIDF(size_t document_frequency) const;
+    
+    // Get the IDF of an indexed term from the index's cached log statistics:
+    // a subtraction, with no hashing or logarithms at query time
+    double getCachedIDF(uint32_t term_id) const {
+        return index_.getLogTotalDocuments() - index_.getLogDocumentFrequency(term_id);
+    }
+    
+    // Quantize the logarithmic TF weight into an 8-bit impact. Impacts depend
+    // only on tf, so they stay valid as documents are added.
+    static uint8_t quantizeTF(size_t term_frequency);
+    
+    // Get the TF weight an impact stands for
+    static double impactWeight(uint8_t impact) { return impact * kImpactStep; }
+    
     // Calculate TF-IDF score for a term in a document
     double calculateTFIDF(const std::string& term, const Document& doc) const;
     
 private:
+    // Impact resolution: 255 steps span TF weights up to 1 + ln(65535)
+    static constexpr double kImpactStep = 12.0903 / 255.0;
+    
     const InvertedIndex& index_;
 };
 
@@ -0,0 +1,193 @@
+#ifndef TERM_DICTIONARY_HPP
+#define TERM_DICTIONARY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "BinaryIO.hpp"
+
+// Immutable term dictionary stored as a minimal acyclic finite-state
+// automaton (Daciuk et al., 2000). Terms sharing prefixes or suffixes share
+// states, so a vocabulary takes a fraction of the space of its strings.
+//
+// A term's ID is its rank in byte order. Every arc records how many terms
+// sort before those reached through it, so walking a term sums its rank
+// and walking down by rank spells a term; IDs of a prefix or range are
+// contiguous. An optional frequency per term is kept in an array by ID.
+//
+// The serialized form is also the in-memory representation, so it can be
+// used in place, e.g. inside a memory-mapped index segment:
+//   Header
+//   uint32_t frequencies[term_count]   if kHasFrequencies
+//   states                             byte-coded, root first
+//
+// A state is a flags byte, an arc count byte if it has several arcs, the
+// arc labels in order, then per arc a target and (after the first) a rank,
+// each in the fewest bytes that fit the state's largest. Targets are
+// offsets from the end of the state, so they always point forward; a
+// state's last child is usually stored right after it, and its target is
+// then left out. A chain of single-letter states costs two bytes a letter.
+class TermDictionary {
+public:
+    static constexpr uint32_t kNotFound = UINT32_MAX;
+
+    // An empty dictionary
+    TermDictionary();
+
+    // Use serialized bytes in place; owner keeps them alive. Only the
+    // header is checked here and states are bounds-checked when visited.
+    // Throws std::runtime_error if the bytes are not a valid dictionary.
+    TermDictionary(std::shared_ptr<const void> owner, const char* data, size_t size);
+
+    // Append a dictionary of terms, which must be sorted and unique, to
+    // writer at a 4-byte aligned offset. frequencies, if given, holds one
+    // value per term. Throws std::invalid_argument for unsorted terms.
+    static void write(const std::vector<std::string_view>& terms, const uint32_t* frequencies,
+                      BinaryWriter& writer);
+
+    // Check every state once: labels are sorted, every state but the root
+    // leads to a term and each arc's rank counts the terms before it. After
+    // it passes, lookups never fail or return IDs past size(). Costs a walk
+    // over the whole automaton; throws std::runtime_error if a check fails.
+    void validate() const;
+
+    // Build a dictionary in memory
+    static TermDictionary build(const std::vector<std::string_view>& terms, const uint32_t* frequencies = nullptr);
+
+    size_t size() const { return header_->term_count; }
+
+    // ID of a term, or kNotFound
+    uint32_t find(std::string_view term) const;
+
+    // The term with an ID
+    std::string getTerm(uint32_t id) const;
+
+    // Frequency of the term with an ID, or 0 if none were stored
+    uint32_t getFrequency(uint32_t id) const { return frequencies_ ? frequencies_[id] : 0; }
+    bool hasFrequencies() const { return frequencies_ != nullptr; }
+
+    // Number of terms sorting before term, which is term's ID if present
+    uint32_t lowerBound(std::string_view term) const;
+
+    // IDs [first, last) of the terms starting with prefix, and of the terms
+    // in [low, high)
+    std::pair<uint32_t, uint32_t> prefixRange(std::string_view prefix) const;
+    std::pair<uint32_t, uint32_t> range(std::string_view low, std::string_view high) const;
+
+    // Call visitor(term, id) for every term an automaton accepts, in order.
+    // The automaton provides:
+    //   State start() const;
+    //   State step(const State& state, unsigned char c) const;
+    //   bool isMatch(const State& state) const;     accepts the input so far
+    //   bool canMatch(const State& state) const;    may accept an extension
+    // Branches where canMatch fails are not visited. The walk keeps its
+    // own stack, so term length does not bound it.
+    template <typename Automaton, typename Visitor>
+    void intersect(const Automaton& automaton, Visitor&& visitor) const {
+        // One frame per state on the path; term spells the path
+        struct Frame {
+            State state;
+            uint32_t offset;
+            typename Automaton::State current;
+            uint32_t arc;
+        };
+        std::vector<Frame> stack;
+        std::string term;
+        auto enter = [&](size_t address, uint32_t offset, typename Automaton::State current) {
+            if (!automaton.canMatch(current)) return false;
+            State state = decode(address);
+            if (state.final && automaton.isMatch(current)) {
+                visitor(std::string_view(term), offset);
+            }
+            stack.push_back({state, offset, std::move(current), 0});
+            return true;
+        };
+
+        enter(0, 0, automaton.start());
+        while (!stack.empty()) {
+            Frame& frame = stack.back();
+            if (frame.arc == frame.state.num_arcs) {
+                stack.pop_back();
+                if (!stack.empty()) term.pop_back();
+                continue;
+            }
+            uint32_t arc = frame.arc++;
+            unsigned char label = frame.state.labels[arc];
+            term.push_back(static_cast<char>(label));
+            if (!enter(target(frame.state, arc), frame.offset + rank(frame.state, arc),
+                       automaton.step(frame.current, label))) {
+                term.pop_back();
+            }
+        }
+    }
+
+    // Call visitor(term, id) for every term, in order
+    template <typename Visitor>
+    void forEach(Visitor&& visitor) const {
+        intersect(AcceptAll(), visitor);
+    }
+
+    // The serialized form, e.g. for copying it into a file
+    std::string_view bytes() const { return {reinterpret_cast<const char*>(header_), size_}; }
+    size_t memoryUsage() const { return size_; }
+
+private:
+    static constexpr uint32_t kHasFrequencies = 1;
+
+    struct Header {
+        uint32_t term_count;
+        uint32_t flags;
+        uint64_t automaton_size;
+    };
+
+    // A decoded state
+    struct State {
+        bool final;
+        uint32_t num_arcs;
+        const uint8_t* labels;
+        const uint8_t* targets;
+        const uint8_t* ranks;
+        uint8_t target_width;
+        uint8_t rank_width;
+        bool last_is_next;      // The last arc leads to the following state
+        size_t end;             // Address after the state
+    };
+
+    struct AcceptAll {
+        using State = bool;
+        State start() const { return true; }
+        State step(const State&, unsigned char) const { return true; }
+        bool isMatch(const State&) const { return true; }
+        bool canMatch(const State&) const { return true; }
+    };
+
+    // Shared by default-constructed dictionaries
+    static const TermDictionary& empty();
+
+    std::shared_ptr<const void> owner_;
+    size_t size_;
+    const Header* header_;
+    const uint32_t* frequencies_;
+    const uint8_t* automaton_;
+    size_t automaton_size_;
+
+    // Decode the state at an address, bounds-checked
+    State decode(size_t address) const;
+
+    // Address of the state an arc leads to, and the number of terms before
+    // those through it
+    size_t target(const State& state, uint32_t arc) const;
+    uint32_t rank(const State& state, uint32_t arc) const;
+
+    // Arc labelled c, or kNotFound
+    uint32_t findArc(const State& state, unsigned char c) const;
+
+    // Number of terms reachable from a state
+    uint32_t countTerms(State state) const;
+};
+
+#endif // TERM_DICTIONARY_HPP
\ No newline at end of file
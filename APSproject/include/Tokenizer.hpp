@@ -0,0 +1,56 @@
+#ifndef TOKENIZER_HPP
+#define TOKENIZER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Splits text into index terms. Tokens are separated by ASCII whitespace;
+// within a token only ASCII letters and digits are kept, and letters are
+// lowercased. Documents and queries both use it, so they agree on terms.
+//
+// Text is classified 64 bytes at a time with SSE2 or AVX2 kernels chosen at
+// runtime: whitespace and "already normalized" bytes become bitmasks, token
+// boundaries are read off the masks, and tokens that are already lowercase
+// alphanumerics are returned as views into the text without copying. Other
+// tokens are case-folded 16-32 bytes at a time into an internal buffer.
+class Tokenizer {
+public:
+    // Longer terms are dropped, so one runaway token cannot bloat the
+    // dictionaries
+    static constexpr size_t kMaxTermLength = 255;
+
+    explicit Tokenizer(std::string_view text) : text_(text) {}
+
+    // Get the next non-empty term of at most kMaxTermLength bytes. The view
+    // points into the text or into the tokenizer and is valid until the next
+    // call. Returns false at the end.
+    bool next(std::string_view& term);
+
+    // Collect every term of a text
+    static std::vector<std::string> tokenize(std::string_view text);
+
+private:
+    static constexpr size_t kNoToken = static_cast<size_t>(-1);
+
+    std::string_view text_;
+    size_t block_start_{0};       // Offset of the classified block
+    size_t next_block_{0};        // Offset of the next block to classify
+    uint64_t space_{~0ull};       // Whitespace bits of the block
+    uint64_t dirty_{0};           // Bits of bytes that need normalizing
+    uint64_t transitions_{0};     // Unvisited token starts and ends
+    bool previous_space_{true};   // Whether the byte before the block is whitespace
+    size_t token_start_{kNoToken};
+    bool token_dirty_{false};     // Dirty bytes seen in earlier blocks of the token
+    std::string scratch_;
+
+    // Classify the next block; returns false when the text is exhausted
+    bool loadBlock();
+
+    // Produce the term for text_[start, end); returns false if it is empty
+    bool finishToken(size_t end, std::string_view& term);
+};
+
+#endif // TOKENIZER_HPP
\ No newline at end of file
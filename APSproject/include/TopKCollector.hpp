@@ -0,0 +1,64 @@
+#ifndef TOP_K_COLLECTOR_HPP
+#define TOP_K_COLLECTOR_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Fixed-capacity min-heap that keeps the k best (doc_id, score) pairs seen.
+// Offering n candidates costs O(n log k) time and O(k) memory, instead of
+// materializing and sorting all n.
+class TopKCollector {
+public:
+    using Entry = std::pair<uint32_t, double>;
+
+    // Capacity reserved up front when the caller gives no better estimate
+    static constexpr size_t kDefaultReserve = 1024;
+
+    // k may exceed the number of candidates (even SIZE_MAX); the heap only
+    // grows with the entries actually retained. expected_candidates, when
+    // known, sizes the first allocation.
+    explicit TopKCollector(size_t k, size_t expected_candidates = kDefaultReserve) : k_(k) {
+        heap_.reserve(std::min(k, expected_candidates));
+    }
+
+    // Offer a scored document; returns true if it was retained. Zero scores
+    // are kept too, for Boolean matches no query term scores. Ties favor the
+    // smaller document ID.
+    bool offer(uint32_t doc_id, double score) {
+        if (heap_.size() < k_) {
+            heap_.emplace_back(doc_id, score);
+            siftUp(heap_.size() - 1);
+            return true;
+        }
+        if (k_ == 0 || !better({doc_id, score}, heap_.front())) return false;
+        heap_.front() = {doc_id, score};
+        siftDown(0);
+        return true;
+    }
+
+    // Score a candidate must exceed to be retained (0 until the heap is full)
+    double threshold() const { return heap_.size() < k_ ? 0.0 : heap_.front().second; }
+
+    // Number of retained entries
+    size_t size() const { return heap_.size(); }
+
+    // Extract retained entries best first; leaves the collector empty
+    std::vector<Entry> takeSorted();
+
+    // Result ordering: higher score first, then smaller document ID
+    static bool better(const Entry& a, const Entry& b) {
+        return a.second > b.second || (a.second == b.second && a.first < b.first);
+    }
+
+private:
+    size_t k_;
+    std::vector<Entry> heap_;   // heap_.front() is the weakest retained entry
+
+    void siftUp(size_t i);
+    void siftDown(size_t i);
+};
+
+#endif // TOP_K_COLLECTOR_HPP
\ No newline at end of file
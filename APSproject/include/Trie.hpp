@@ -1,44 +1,130 @@
 #ifndef TRIE_HPP
 #define TRIE_HPP
 
+#include <array>
+#include <cstdint>
 #include <string>
+#include <utility>
 #include <vector>
-#include <memory>
-#include <unordered_map>
+#include "BinaryIO.hpp"
+#include "LevenshteinAutomaton.hpp"
 
+// Prefix tree for autocomplete. Nodes live in one contiguous arena and
+// refer to each other by 32-bit index. A node's children are a sorted run
+// of labels with a parallel run of child indices, both in shared pools, so
+// a lookup scans a few adjacent bytes instead of hashing and following
+// heap pointers. Only word-ending nodes carry a weight: the word's
+// document frequency plus a query popularity set from outside.
+//
+// Every node also records the highest weight in its subtree, so
+// suggestions come from a best-first search that visits only the branches
+// able to hold the top words, not the whole subtree under the prefix.
 class Trie {
 private:
+    static constexpr uint32_t kNone = UINT32_MAX;
+    
+    // Child runs hold 1, 2, 4, ..., 256 slots
+    static constexpr size_t kSlotClasses = 9;
+    
     struct Node {
-        bool is_end;
-        std::unordered_map<char, std::shared_ptr<Node>> children;
-        size_t frequency;  // Track word frequency for better suggestions
-        
-        Node() : is_end(false), frequency(0) {}
+        uint32_t edges{0};              // First slot of the child run
+        uint32_t word{kNone};           // Index into the word arrays, if a word ends here
+        uint16_t num_children{0};
+        uint8_t slot_class{0};          // The child run holds 1 << slot_class slots
     };
     
-    std::shared_ptr<Node> root_;
+    std::vector<Node> nodes_;
+    std::vector<unsigned char> labels_;     // Child labels, sorted per node
+    std::vector<uint32_t> children_;        // Child node indices, parallel to labels_
+    std::array<std::vector<uint32_t>, kSlotClasses> free_runs_;
+    
+    // Per word
+    std::vector<size_t> frequencies_;
+    std::vector<size_t> popularity_;
+    
+    // Highest word weight in each node's subtree, indexed like nodes_
+    std::vector<size_t> subtree_max_;
     size_t max_suggestions_;
     
-    void findAllWords(const std::shared_ptr<Node>& node, const std::string& prefix,
-                     std::vector<std::pair<std::string, size_t>>& result) const;
+    // Child of node labelled c, or kNone
+    uint32_t findChild(uint32_t node, unsigned char c) const;
+    
+    // Add a child labelled c, which must not exist, and return its index
+    uint32_t addChild(uint32_t node, unsigned char c);
+    
+    // Node reached by following word from the root, or kNone
+    uint32_t find(const std::string& word) const;
+    
+    // Allocate a run of 1 << slot_class child slots
+    uint32_t allocateRun(uint8_t slot_class);
+    
+    size_t weight(uint32_t word) const { return frequencies_[word] + popularity_[word]; }
+    
+    // Raise the subtree maximum of every node on the path of word to at
+    // least weight
+    void raiseSubtreeMax(const std::string& word, size_t weight);
+    
+    // Recompute the subtree maxima on the path of word from the bottom up,
+    // after a weight on it decreased
+    void recomputeSubtreeMax(const std::string& word);
+    
+    // A queued subtree, or a single word (node kNone). A settled subtree
+    // completes the prefix at distance; an unsettled one has the automaton
+    // state of its path, and distance is a lower bound.
+    struct Completion {
+        size_t distance;
+        size_t weight;              // Of the word, or the subtree maximum
+        uint32_t node;
+        std::string path;
+        size_t best;                // Distance of the closest prefix of path
+        uint32_t row;               // Index of the automaton state, or kNone
+    };
+    
+    // The first max_suggestions_ words below node, which is reached by
+    // path; with an automaton, those completing anything it accepts
+    std::vector<std::string> complete(uint32_t node, const std::string& path,
+                                      const LevenshteinAutomaton* automaton) const;
+    
+    // Append every word below node, in lexicographic order; word holds the
+    // path to node on entry and on return
+    void findAllWords(uint32_t node, std::string& word,
+                      std::vector<std::pair<std::string, size_t>>& result) const;
     
 public:
-    explicit Trie(size_t max_suggestions = 5) : root_(std::make_shared<Node>()), max_suggestions_(max_suggestions) {}
+    explicit Trie(size_t max_suggestions = 5);
     
-    // Insert a word into the trie
-    void insert(const std::string& word);
+    // Insert a word into the trie, adding count to its frequency
+    void insert(const std::string& word, size_t count = 1);
     
     // Get autocomplete suggestions for a prefix
     std::vector<std::string> getSuggestions(const std::string& prefix) const;
     
+    // Get suggestions for a prefix that may contain typos: completions of
+    // every string within max_distance edits of it, closest first. Walks
+    // the trie in lockstep with a Levenshtein automaton, so only branches
+    // that can still match are visited.
+    std::vector<std::string> getFuzzySuggestions(const std::string& prefix, size_t max_distance) const;
+    
     // Check if a word exists in the trie
     bool contains(const std::string& word) const;
     
-    // Increment frequency of a word
-    void incrementFrequency(const std::string& word);
+    // Set the query popularity added to a word's frequency when ranking
+    // suggestions; words not in the trie are ignored
+    void setPopularity(const std::string& word, size_t popularity);
+    
+    // Number of distinct words
+    size_t size() const { return frequencies_.size(); }
+    
+    // Approximate heap usage in bytes
+    size_t memoryUsage() const;
     
     // Clear all entries
     void clear();
+    
+    // Write every word with its frequency, and read them back into this
+    // trie (replacing its contents). Popularity is not stored.
+    void serialize(BinaryWriter& writer) const;
+    void deserialize(BinaryReader& reader);
 };
 
-#endif // TRIE_HPP 
\ No newline at end of file
+#endif // TRIE_HPP
\ No newline at end of file
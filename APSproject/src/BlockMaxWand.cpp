@@ -0,0 +1,113 @@
+#include "BlockMaxWand.hpp"
+#include <algorithm>
+
+std::vector<std::pair<uint32_t, double>> BlockMaxWand::search(std::vector<Term> terms, size_t k) const {
+    if (k == 0 || terms.empty()) return {};
+
+    // Upper bound for a term given a bounding term frequency. Impacts are
+    // monotone in tf, so quantizing the bound keeps it valid.
+    auto termScore = [this](const Term& term, uint32_t term_frequency) {
+        double weight = term.cursor.hasImpacts()
+            ? TFIDFCalculator::impactWeight(TFIDFCalculator::quantizeTF(term_frequency))
+            : calculator_.calculateTF(term_frequency);
+        return weight * term.idf;
+    };
+    
+    // Actual score of the posting under a term's cursor
+    auto postingScore = [this](Term& term) {
+        double weight = term.cursor.hasImpacts()
+            ? TFIDFCalculator::impactWeight(term.cursor.impact())
+            : calculator_.calculateTF(term.cursor.termFrequency());
+        return weight * term.idf;
+    };
+
+    std::vector<double> max_scores;
+    max_scores.reserve(terms.size());
+    std::vector<Term*> order;
+    order.reserve(terms.size());
+    for (auto& term : terms) {
+        max_scores.push_back(termScore(term, term.max_term_frequency));
+        order.push_back(&term);
+    }
+    auto maxScore = [&](const Term* term) { return max_scores[term - terms.data()]; };
+
+    TopKCollector top_k(k);
+
+    const size_t n = order.size();
+    while (true) {
+        // Keep cursors sorted by current document; lists are short and
+        // nearly sorted between iterations, so insertion sort is cheapest
+        for (size_t i = 1; i < n; ++i) {
+            for (size_t j = i; j > 0 && order[j]->cursor.docId() < order[j - 1]->cursor.docId(); --j) {
+                std::swap(order[j], order[j - 1]);
+            }
+        }
+
+        // Find the pivot: the first list at which the summed term upper
+        // bounds could beat the current threshold
+        double theta = top_k.threshold();
+        double upper_bound = 0.0;
+        size_t pivot = n;
+        for (size_t i = 0; i < n && order[i]->cursor.docId() != PostingCursor::kEnd; ++i) {
+            upper_bound += maxScore(order[i]);
+            if (upper_bound > theta) {
+                pivot = i;
+                break;
+            }
+        }
+        if (pivot == n) break;
+
+        uint32_t pivot_doc = order[pivot]->cursor.docId();
+        while (pivot + 1 < n && order[pivot + 1]->cursor.docId() == pivot_doc) {
+            ++pivot;
+        }
+
+        // Refine the bound with the blocks that would hold the pivot document
+        double block_bound = 0.0;
+        for (size_t i = 0; i <= pivot; ++i) {
+            order[i]->cursor.shallowAdvance(pivot_doc);
+            block_bound += termScore(*order[i], order[i]->cursor.blockMaxTermFrequency());
+        }
+
+        if (block_bound > theta) {
+            if (order[0]->cursor.docId() == pivot_doc) {
+                // Every list up to the pivot is on the pivot document: score it
+                double score = 0.0;
+                for (size_t i = 0; i <= pivot; ++i) {
+                    score += postingScore(*order[i]);
+                    order[i]->cursor.next();
+                }
+                top_k.offer(pivot_doc, score);
+            }
+            else {
+                // Bring the most promising lagging list up to the pivot
+                size_t best = 0;
+                for (size_t i = 1; i < pivot && order[i]->cursor.docId() < pivot_doc; ++i) {
+                    if (maxScore(order[i]) > maxScore(order[best])) best = i;
+                }
+                order[best]->cursor.nextGEQ(pivot_doc);
+            }
+        }
+        else {
+            // No document before the end of the shallowest current block can
+            // qualify, and lists after the pivot start later still
+            uint32_t next_doc = PostingCursor::kEnd;
+            for (size_t i = 0; i <= pivot; ++i) {
+                next_doc = std::min(next_doc, order[i]->cursor.blockLastDocId());
+            }
+            if (next_doc != PostingCursor::kEnd) ++next_doc;
+            if (pivot + 1 < n) {
+                next_doc = std::min(next_doc, order[pivot + 1]->cursor.docId());
+            }
+            if (next_doc <= pivot_doc) next_doc = pivot_doc + 1;
+
+            size_t best = 0;
+            for (size_t i = 1; i <= pivot; ++i) {
+                if (maxScore(order[i]) > maxScore(order[best])) best = i;
+            }
+            order[best]->cursor.nextGEQ(next_doc);
+        }
+    }
+
+    return top_k.takeSorted();
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#include "Codec.hpp"
+#include "HuffmanCompression.hpp"
+#include "RansCompression.hpp"
+
+const Codec* Codec::get(Id id) {
+    static const HuffmanCompression huffman;
+    static const RansCompression rans;
+    switch (id) {
+        case Id::Huffman: return &huffman;
+        case Id::Rans: return &rans;
+    }
+    return nullptr;
+}
\ No newline at end of file
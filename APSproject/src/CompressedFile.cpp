@@ -0,0 +1,174 @@
+#include "CompressedFile.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+constexpr char kHeaderMagic[8] = {'A', 'P', 'S', 'B', 'L', 'O', 'C', 'K'};
+constexpr char kFooterMagic[8] = {'A', 'P', 'S', 'B', 'L', 'K', 'I', 'X'};
+constexpr size_t kHeaderSize = sizeof(kHeaderMagic) + 3 * sizeof(uint32_t);
+constexpr size_t kFooterSize = 2 * sizeof(uint64_t) + sizeof(kFooterMagic);
+constexpr size_t kEntryFields = 3;
+
+// Larger blocks are taken as damage rather than allocated
+constexpr size_t kMaxBlockSize = size_t{1} << 30;
+
+[[noreturn]] void corrupt() {
+    throw std::runtime_error("Corrupt compressed file");
+}
+
+template <typename T>
+T load(const char* data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+} // namespace
+
+CompressedFile::Writer::Writer(std::ostream& out, ThreadPool& pool, const Codec& codec, size_t block_size)
+    : out_(out), pool_(pool), codec_(codec), block_size_(std::clamp<size_t>(block_size, 1, kMaxBlockSize)),
+      offset_(kHeaderSize) {
+    uint32_t version = kFormatVersion;
+    uint32_t stored_block_size = static_cast<uint32_t>(block_size_);
+    uint32_t codec_id = static_cast<uint32_t>(codec_.id());
+    out_.write(kHeaderMagic, sizeof(kHeaderMagic));
+    out_.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    out_.write(reinterpret_cast<const char*>(&stored_block_size), sizeof(stored_block_size));
+    out_.write(reinterpret_cast<const char*>(&codec_id), sizeof(codec_id));
+    buffer_.reserve(block_size_);
+}
+
+void CompressedFile::Writer::write(const char* data, size_t size) {
+    while (size > 0) {
+        size_t take = std::min(size, block_size_ - buffer_.size());
+        buffer_.append(data, take);
+        data += take;
+        size -= take;
+        if (buffer_.size() == block_size_) {
+            submitBlock();
+        }
+    }
+}
+
+void CompressedFile::Writer::submitBlock() {
+    // Wait for the oldest block once every worker has two queued
+    while (pending_.size() >= 2 * pool_.size()) {
+        writeOldestBlock();
+    }
+
+    size_t raw_size = buffer_.size();
+    pending_.emplace_back(raw_size, pool_.submit([&codec = codec_, block = std::move(buffer_)]() {
+        return codec.compress(block.data(), block.size());
+    }));
+    buffer_ = std::string();
+    buffer_.reserve(block_size_);
+}
+
+void CompressedFile::Writer::writeOldestBlock() {
+    auto [raw_size, future] = std::move(pending_.front());
+    pending_.pop_front();
+    std::vector<unsigned char> block = future.get();
+
+    out_.write(reinterpret_cast<const char*>(block.data()), static_cast<std::streamsize>(block.size()));
+    index_.insert(index_.end(), {offset_, block.size(), raw_size});
+    offset_ += block.size();
+}
+
+bool CompressedFile::Writer::finish() {
+    if (!buffer_.empty()) {
+        submitBlock();
+    }
+    while (!pending_.empty()) {
+        writeOldestBlock();
+    }
+
+    uint64_t block_count = index_.size() / kEntryFields;
+    out_.write(reinterpret_cast<const char*>(index_.data()),
+               static_cast<std::streamsize>(index_.size() * sizeof(uint64_t)));
+    out_.write(reinterpret_cast<const char*>(&block_count), sizeof(block_count));
+    out_.write(reinterpret_cast<const char*>(&offset_), sizeof(offset_));
+    out_.write(kFooterMagic, sizeof(kFooterMagic));
+    out_.flush();
+    return static_cast<bool>(out_);
+}
+
+bool CompressedFile::isCompressed(const char* data, size_t size) {
+    return size >= sizeof(kHeaderMagic) && std::memcmp(data, kHeaderMagic, sizeof(kHeaderMagic)) == 0;
+}
+
+std::string CompressedFile::decompress(const char* data, size_t size, ThreadPool& pool) {
+    if (!isCompressed(data, size) || size < kHeaderSize + kFooterSize ||
+        load<uint32_t>(data + sizeof(kHeaderMagic)) != kFormatVersion ||
+        std::memcmp(data + size - sizeof(kFooterMagic), kFooterMagic, sizeof(kFooterMagic)) != 0) {
+        corrupt();
+    }
+    size_t block_size = load<uint32_t>(data + sizeof(kHeaderMagic) + sizeof(uint32_t));
+    const Codec* codec = Codec::get(static_cast<Codec::Id>(load<uint32_t>(data + sizeof(kHeaderMagic) + 2 * sizeof(uint32_t))));
+    if (!codec || block_size == 0 || block_size > kMaxBlockSize) corrupt();
+
+    // Locate the block index and check every entry against the file. The
+    // writer fills every block but the last, and each block's stream must be
+    // able to hold its raw size, so nothing is allocated for sizes that a
+    // damaged index merely claims.
+    const char* footer = data + size - kFooterSize;
+    uint64_t block_count = load<uint64_t>(footer);
+    uint64_t index_offset = load<uint64_t>(footer + sizeof(uint64_t));
+    if (index_offset < kHeaderSize || index_offset > size - kFooterSize ||
+        block_count != (size - kFooterSize - index_offset) / (kEntryFields * sizeof(uint64_t)) ||
+        (size - kFooterSize - index_offset) % (kEntryFields * sizeof(uint64_t)) != 0) {
+        corrupt();
+    }
+
+    struct Block {
+        const char* compressed;
+        size_t compressed_size;
+        size_t raw_offset;
+        size_t raw_size;
+    };
+    std::vector<Block> blocks(block_count);
+    uint64_t expected_offset = kHeaderSize;
+    size_t raw_total = 0;
+    for (size_t b = 0; b < block_count; ++b) {
+        const char* entry = data + index_offset + b * kEntryFields * sizeof(uint64_t);
+        uint64_t offset = load<uint64_t>(entry);
+        uint64_t compressed_size = load<uint64_t>(entry + sizeof(uint64_t));
+        uint64_t raw_size = load<uint64_t>(entry + 2 * sizeof(uint64_t));
+        bool last = b + 1 == block_count;
+        if (offset != expected_offset || compressed_size > index_offset - offset || raw_size == 0 ||
+            (last ? raw_size > block_size : raw_size != block_size) ||
+            raw_size > codec->maxDecodedSize(reinterpret_cast<const unsigned char*>(data + offset), compressed_size)) {
+            corrupt();
+        }
+        blocks[b] = {data + offset, compressed_size, raw_total, raw_size};
+        expected_offset = offset + compressed_size;
+        raw_total += raw_size;
+    }
+    if (expected_offset != index_offset) corrupt();
+    
+    // A block of one repeated byte codes to a few dozen bytes whatever its
+    // size, so the total can still exceed memory; that fails as bad_alloc
+
+    // One contiguous run of blocks per worker, decoded straight into place
+    std::string output(raw_total, '\0');
+    size_t num_tasks = std::min(pool.size(), blocks.size());
+    std::vector<std::future<void>> tasks;
+    tasks.reserve(num_tasks);
+    for (size_t t = 0; t < num_tasks; ++t) {
+        size_t begin = blocks.size() * t / num_tasks;
+        size_t end = blocks.size() * (t + 1) / num_tasks;
+        tasks.push_back(pool.submit([codec, &blocks, &output, begin, end]() {
+            for (size_t b = begin; b < end; ++b) {
+                codec->decompress(reinterpret_cast<const unsigned char*>(blocks[b].compressed),
+                                   blocks[b].compressed_size, output.data() + blocks[b].raw_offset,
+                                   blocks[b].raw_size);
+            }
+        }));
+    }
+
+    // Tasks write into output, so wait for all of them before any rethrow
+    for (auto& task : tasks) task.wait();
+    for (auto& task : tasks) task.get();
+    return output;
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#include "CpuFeatures.hpp"
+
+#if defined(SEARCH_ENGINE_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace {
+
+struct Features {
+    bool sse2{false};
+    bool ssse3{false};
+    bool avx2{false};
+
+    Features() {
+#if defined(SEARCH_ENGINE_X86) && (defined(__GNUC__) || defined(__clang__))
+        __builtin_cpu_init();
+        sse2 = __builtin_cpu_supports("sse2");
+        ssse3 = __builtin_cpu_supports("ssse3");
+        avx2 = __builtin_cpu_supports("avx2");
+#elif defined(SEARCH_ENGINE_X86) && defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        int max_leaf = info[0];
+
+        __cpuid(info, 1);
+        sse2 = (info[3] & (1 << 26)) != 0;
+        ssse3 = (info[2] & (1 << 9)) != 0;
+        bool os_saves_ymm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+
+        if (max_leaf >= 7) {
+            __cpuidex(info, 7, 0);
+            avx2 = os_saves_ymm && (info[1] & (1 << 5)) != 0;
+        }
+#endif
+    }
+};
+
+const Features& features() {
+    static const Features detected;
+    return detected;
+}
+
+} // namespace
+
+bool CpuFeatures::hasSSE2() {
+    return features().sse2;
+}
+
+bool CpuFeatures::hasSSSE3() {
+    return features().ssse3;
+}
+
+bool CpuFeatures::hasAVX2() {
+    return features().avx2;
+}
\ No newline at end of file
@@ -1,44 +1,52 @@
 #include "Document.hpp"
-#include <fstream>
-#include <sstream>
-#include <algorithm>
-#include <cctype>
+#include "MappedFile.hpp"
+#include "Tokenizer.hpp"
 
 Document::Document(const std::string& id, const std::string& path)
-    : id_(id), path_(path), total_words_(0) {}
+    : id_(id), path_(path), total_words_(0), has_positions_(false) {}
 
-bool Document::parse() {
-    std::ifstream file(path_);
-    if (!file.is_open()) {
+Document::Document(const Document& other)
+    : id_(other.id_), path_(other.path_), total_words_(other.total_words_), has_positions_(other.has_positions_) {
+    word_occurrences_.reserve(other.word_occurrences_.size());
+    for (const auto& [word, occurrences] : other.word_occurrences_) {
+        words_.emplace_back(word);
+        word_occurrences_.emplace(words_.back(), occurrences);
+    }
+}
+
+Document& Document::operator=(const Document& other) {
+    if (this != &other) {
+        *this = Document(other);
+    }
+    return *this;
+}
+
+bool Document::parse(bool record_positions) {
+    MappedFile file;
+    if (!file.open(path_, MappedFile::Access::Sequential)) {
         return false;
     }
+    has_positions_ = record_positions;
     
-    std::string line;
-    while (std::getline(file, line)) {
-        std::istringstream iss(line);
-        std::string word;
-        
-        while (iss >> word) {
-            processWord(word);
-        }
+    // Tokenize directly over the mapped bytes
+    Tokenizer tokenizer(file.view());
+    std::string_view term;
+    while (tokenizer.next(term)) {
+        processWord(term);
     }
     
     return true;
 }
 
-void Document::processWord(const std::string& word) {
-    // Convert word to lowercase and remove punctuation
-    std::string processed;
-    processed.reserve(word.length());
-    
-    for (char c : word) {
-        if (std::isalnum(c)) {
-            processed += std::tolower(c);
-        }
+void Document::processWord(std::string_view word) {
+    auto it = word_occurrences_.find(word);
+    if (it == word_occurrences_.end()) {
+        words_.emplace_back(word);
+        it = word_occurrences_.emplace(words_.back(), WordOccurrences()).first;
     }
-    
-    if (!processed.empty()) {
-        word_frequencies_[processed]++;
-        total_words_++;
+    it->second.frequency++;
+    if (has_positions_) {
+        it->second.positions.push_back(static_cast<uint32_t>(total_words_));
     }
-} 
\ No newline at end of file
+    total_words_++;
+}
\ No newline at end of file
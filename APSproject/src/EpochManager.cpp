@@ -0,0 +1,123 @@
+#include "EpochManager.hpp"
+#include <thread>
+
+EpochManager::Guard::Guard(EpochManager& manager) : slot_(manager.acquireSlot()) {
+    // A pin that reads a stale epoch only delays reclamation. The store is
+    // sequentially consistent so a writer scanning after it unlinked an
+    // object either sees this pin or this reader sees the new pointer.
+    slot_->epoch.store(manager.global_epoch_.load());
+}
+
+EpochManager::Guard::~Guard() {
+    release();
+}
+
+EpochManager::Guard& EpochManager::Guard::operator=(Guard&& other) noexcept {
+    if (this != &other) {
+        release();
+        slot_ = other.slot_;
+        other.slot_ = nullptr;
+    }
+    return *this;
+}
+
+void EpochManager::Guard::release() {
+    if (slot_) {
+        slot_->epoch.store(kIdle, std::memory_order_release);
+        slot_->in_use.store(false, std::memory_order_release);
+        slot_ = nullptr;
+    }
+}
+
+EpochManager::~EpochManager() {
+    for (auto& retired : retired_) {
+        retired.deleter();
+    }
+
+    SlotBlock* block = first_block_.next.load();
+    while (block) {
+        SlotBlock* next = block->next.load();
+        delete block;
+        block = next;
+    }
+}
+
+EpochManager::Slot* EpochManager::acquireSlot() {
+    // Spread threads over the slots so concurrent pins rarely contend
+    thread_local const size_t start = std::hash<std::thread::id>()(std::this_thread::get_id()) % kSlotsPerBlock;
+
+    SlotBlock* block = &first_block_;
+    while (true) {
+        for (size_t i = 0; i < kSlotsPerBlock; ++i) {
+            Slot& slot = block->slots[(start + i) % kSlotsPerBlock];
+            if (!slot.in_use.load(std::memory_order_relaxed) &&
+                !slot.in_use.exchange(true, std::memory_order_acquire)) {
+                return &slot;
+            }
+        }
+
+        SlotBlock* next = block->next.load(std::memory_order_acquire);
+        if (!next) {
+            // Every slot is taken: append a block, or follow the one another
+            // thread appended first
+            auto fresh = new SlotBlock();
+            if (block->next.compare_exchange_strong(next, fresh, std::memory_order_acq_rel)) {
+                next = fresh;
+            }
+            else {
+                delete fresh;
+            }
+        }
+        block = next;
+    }
+}
+
+void EpochManager::retire(std::function<void()> deleter) {
+    // Readers pinned at this epoch or earlier may hold the object; later
+    // pins start after it was unlinked
+    uint64_t epoch = global_epoch_.fetch_add(1);
+
+    std::lock_guard<std::mutex> lock(retired_mutex_);
+    retired_.push_back({epoch, std::move(deleter)});
+}
+
+size_t EpochManager::reclaim() {
+    std::vector<Retired> ready;
+    {
+        std::lock_guard<std::mutex> lock(retired_mutex_);
+        uint64_t minimum = minimumPinnedEpoch();
+
+        auto pending = retired_.begin();
+        for (auto& retired : retired_) {
+            if (retired.epoch < minimum) {
+                ready.push_back(std::move(retired));
+            }
+            else {
+                *pending++ = std::move(retired);
+            }
+        }
+        retired_.erase(pending, retired_.end());
+    }
+
+    // Run deleters outside the lock
+    for (auto& retired : ready) {
+        retired.deleter();
+    }
+    return ready.size();
+}
+
+size_t EpochManager::pendingCount() const {
+    std::lock_guard<std::mutex> lock(retired_mutex_);
+    return retired_.size();
+}
+
+uint64_t EpochManager::minimumPinnedEpoch() const {
+    uint64_t minimum = kIdle;
+    for (const SlotBlock* block = &first_block_; block; block = block->next.load(std::memory_order_acquire)) {
+        for (const Slot& slot : block->slots) {
+            uint64_t epoch = slot.epoch.load();
+            if (epoch < minimum) minimum = epoch;
+        }
+    }
+    return minimum;
+}
\ No newline at end of file
@@ -1,105 +1,435 @@
 #include "HuffmanCompression.hpp"
+#include <algorithm>
+#include <array>
 #include <fstream>
 #include <bitset>
 #include <cstring>  // for memcpy
+#include <stdexcept>
 
-void HuffmanCompression::buildEncodingMap(const std::shared_ptr<Node>& node, const std::string& code) {
-    if (!node) return;
-    
-    if (!node->left && !node->right) {
-        encoding_map_[node->character] = code;
+namespace {
+
+// Codes up to this long are resolved by one table probe
+constexpr int kTableBits = 11;
+constexpr size_t kMaxSymbolsPerEntry = 4;
+
+// Bits per code length in the stream header
+constexpr int kLengthBits = 5;
+
+[[noreturn]] void corrupt() {
+    throw std::runtime_error("Corrupt Huffman data");
+}
+
+// MSB-first bit reader. Bits past the end read as zero; callers check
+// position() against the real length once they are done.
+class BitReader {
+public:
+    static constexpr int kWindowBits = 57;
+
+    BitReader(const unsigned char* data, size_t size) : data_(data), size_(size) {}
+
+    // The next bits, MSB first, from one 64-bit load; at least
+    // kWindowBits of them are valid
+    uint64_t window() const {
+        size_t byte = position_ >> 3;
+        uint64_t word = 0;
+        if (byte + 8 <= size_) {
+            const unsigned char* p = data_ + byte;
+            word = uint64_t{p[0]} << 56 | uint64_t{p[1]} << 48 | uint64_t{p[2]} << 40 | uint64_t{p[3]} << 32 |
+                   uint64_t{p[4]} << 24 | uint64_t{p[5]} << 16 | uint64_t{p[6]} << 8 | uint64_t{p[7]};
+        }
+        else {
+            for (size_t i = 0; i < 8; ++i) {
+                word = word << 8 | (byte + i < size_ ? data_[byte + i] : 0);
+            }
+        }
+        return word << (position_ & 7);
+    }
+
+    void skip(int n) { position_ += n; }
+    size_t position() const { return position_; }
+    size_t sizeInBits() const { return size_ * 8; }
+
+private:
+    const unsigned char* data_;
+    size_t size_;
+    size_t position_ = 0;
+};
+
+// MSB-first bit writer into a buffer sized by the caller. Codes gather in a
+// 64-bit accumulator that is stored four bytes at a time.
+class BitWriter {
+public:
+    explicit BitWriter(unsigned char* out) : out_(out) {}
+
+    // Append the low length bits of code (length <= 32)
+    void write(uint32_t code, int length) {
+        buffer_ = buffer_ << length | code;
+        count_ += length;
+        if (count_ >= 32) {
+            count_ -= 32;
+            uint32_t word = static_cast<uint32_t>(buffer_ >> count_);
+            out_[0] = static_cast<unsigned char>(word >> 24);
+            out_[1] = static_cast<unsigned char>(word >> 16);
+            out_[2] = static_cast<unsigned char>(word >> 8);
+            out_[3] = static_cast<unsigned char>(word);
+            out_ += 4;
+        }
+    }
+
+    // Store the remaining bits, zero-padded to a whole byte
+    void finish() {
+        while (count_ > 0) {
+            int shift = count_ - 8;
+            *out_++ = static_cast<unsigned char>(shift >= 0 ? buffer_ >> shift : buffer_ << -shift);
+            count_ = std::max(shift, 0);
+        }
+    }
+
+private:
+    unsigned char* out_;
+    uint64_t buffer_ = 0;
+    int count_ = 0;
+};
+
+// Table-driven canonical Huffman decoder. Each kTableBits-bit prefix of the
+// input maps to every symbol whose code fits entirely inside it, so one
+// probe emits up to kMaxSymbolsPerEntry symbols. Longer codes fall back to
+// a per-length search over the canonical code ranges.
+class CanonicalDecoder {
+public:
+    explicit CanonicalDecoder(const std::array<uint8_t, 256>& lengths) {
+        size_t count_before = 0;
+        for (int symbol = 0; symbol < 256; ++symbol) {
+            if (lengths[symbol] > HuffmanCompression::kMaxCodeLength) corrupt();
+            ++counts_[lengths[symbol]];
+        }
+        counts_[0] = 0;
+
+        // Canonical numbering; reject lengths no prefix code can have
+        uint32_t code = 0;
+        uint64_t kraft = 0;
+        for (int length = 1; length <= HuffmanCompression::kMaxCodeLength; ++length) {
+            code = (code + counts_[length - 1]) << 1;
+            first_codes_[length] = code;
+            first_indexes_[length] = static_cast<uint32_t>(count_before);
+            count_before += counts_[length];
+            kraft += uint64_t{counts_[length]} << (HuffmanCompression::kMaxCodeLength - length);
+        }
+        if (kraft > (uint64_t{1} << HuffmanCompression::kMaxCodeLength)) corrupt();
+
+        for (int length = 1; length <= HuffmanCompression::kMaxCodeLength; ++length) {
+            for (int symbol = 0; symbol < 256; ++symbol) {
+                if (lengths[symbol] == length) symbols_.push_back(static_cast<char>(symbol));
+            }
+        }
+
+        // Single-symbol lookup, then greedy packing of several per entry
+        struct Single {
+            char symbol;
+            uint8_t length;
+        };
+        std::vector<Single> single(size_t{1} << kTableBits, Single{0, 0});
+        for (int length = 1; length <= kTableBits; ++length) {
+            for (uint32_t i = 0; i < counts_[length]; ++i) {
+                uint32_t prefix = (first_codes_[length] + i) << (kTableBits - length);
+                for (uint32_t fill = 0; fill < (1u << (kTableBits - length)); ++fill) {
+                    single[prefix + fill] = {symbols_[first_indexes_[length] + i], static_cast<uint8_t>(length)};
+                }
+            }
+        }
+
+        table_.resize(single.size());
+        const uint32_t mask = (1u << kTableBits) - 1;
+        for (uint32_t index = 0; index < table_.size(); ++index) {
+            Entry& entry = table_[index];
+            uint8_t consumed = 0;
+            while (entry.count < kMaxSymbolsPerEntry) {
+                const Single& next = single[(index << consumed) & mask];
+                if (next.length == 0 || consumed + next.length > kTableBits) break;
+                consumed += next.length;
+                entry.symbols[entry.count] = next.symbol;
+                entry.ends[entry.count] = consumed;
+                ++entry.count;
+            }
+        }
+    }
+
+    // Decode exactly n symbols
+    void decode(BitReader& reader, char* out, size_t n) const {
+        size_t produced = 0;
+        while (produced < n) {
+            // Probe the table until the window may no longer hold a full code
+            uint64_t window = reader.window();
+            int consumed = 0;
+            while (consumed + HuffmanCompression::kMaxCodeLength <= BitReader::kWindowBits && produced < n) {
+                uint64_t bits = window << consumed;
+                const Entry& entry = table_[bits >> (64 - kTableBits)];
+                if (entry.count > 0) {
+                    size_t take = std::min<size_t>(entry.count, n - produced);
+                    std::memcpy(out + produced, entry.symbols, take);
+                    consumed += entry.ends[take - 1];
+                    produced += take;
+                }
+                else {
+                    out[produced++] = decodeLong(bits, consumed);
+                }
+            }
+            reader.skip(consumed);
+        }
+        if (reader.position() > reader.sizeInBits()) corrupt();
+    }
+
+private:
+    struct Entry {
+        char symbols[kMaxSymbolsPerEntry];
+        uint8_t ends[kMaxSymbolsPerEntry];   // Bits consumed through each symbol
+        uint8_t count = 0;
+    };
+
+    uint32_t counts_[HuffmanCompression::kMaxCodeLength + 1] = {};
+    uint32_t first_codes_[HuffmanCompression::kMaxCodeLength + 1] = {};
+    uint32_t first_indexes_[HuffmanCompression::kMaxCodeLength + 1] = {};
+    std::vector<char> symbols_;    // Sorted by (code length, byte value)
+    std::vector<Entry> table_;
+
+    // Decode a code longer than kTableBits from the top of bits
+    char decodeLong(uint64_t bits, int& consumed) const {
+        for (int length = kTableBits + 1; length <= HuffmanCompression::kMaxCodeLength; ++length) {
+            uint32_t offset = static_cast<uint32_t>(bits >> (64 - length)) - first_codes_[length];
+            if (offset < counts_[length]) {
+                consumed += length;
+                return symbols_[first_indexes_[length] + offset];
+            }
+        }
+        corrupt();
+    }
+};
+
+using CodeLengths = std::array<uint8_t, 256>;
+
+// Minimum-redundancy code lengths in place (Moffat & Katajainen, 1995):
+// weights holds frequencies in ascending order on entry and the matching
+// code lengths on return. The sorted leaves and the internal nodes, which
+// are formed in ascending order too, are merged like two queues, so no
+// tree is allocated.
+void minimumRedundancyLengths(std::vector<size_t>& weights) {
+    const ptrdiff_t n = static_cast<ptrdiff_t>(weights.size());
+    if (n == 1) {
+        weights[0] = 0;
         return;
     }
-    
-    buildEncodingMap(node->left, code + "0");
-    buildEncodingMap(node->right, code + "1");
+
+    // Combine the two lightest items n - 1 times; internal node weights
+    // are stored over the consumed leaves, and then replaced by parent links
+    weights[0] += weights[1];
+    ptrdiff_t root = 0;
+    ptrdiff_t leaf = 2;
+    for (ptrdiff_t next = 1; next < n - 1; ++next) {
+        for (int child = 0; child < 2; ++child) {
+            size_t weight;
+            if (leaf >= n || (root < next && weights[root] < weights[leaf])) {
+                weight = weights[root];
+                weights[root++] = static_cast<size_t>(next);
+            }
+            else {
+                weight = weights[leaf++];
+            }
+            weights[next] = child == 0 ? weight : weights[next] + weight;
+        }
+    }
+
+    // Internal node depths from the parent links, root last
+    weights[n - 2] = 0;
+    for (ptrdiff_t next = n - 3; next >= 0; --next) {
+        weights[next] = weights[weights[next]] + 1;
+    }
+
+    // Leaf depths: every node available at a depth that is not internal
+    // is a leaf, assigned from the heaviest leaf down
+    ptrdiff_t available = 1;
+    ptrdiff_t next = n - 1;
+    root = n - 2;
+    for (size_t depth = 0; available > 0; ++depth) {
+        ptrdiff_t used = 0;
+        while (root >= 0 && weights[root] == depth) {
+            ++used;
+            --root;
+        }
+        while (available > used) {
+            weights[next--] = depth;
+            --available;
+        }
+        available = 2 * used;
+    }
 }
 
-std::vector<unsigned char> HuffmanCompression::compress(const std::string& data) {
-    if (data.empty()) return {};
-    
-    // Count character frequencies
-    std::unordered_map<char, size_t> frequencies;
-    for (char c : data) {
-        frequencies[c]++;
+// Huffman code lengths for the byte frequencies, limited to kMaxCodeLength
+// bits by flattening the frequencies until they fit
+CodeLengths buildCodeLengths(std::array<size_t, 256> frequencies) {
+    std::vector<uint8_t> symbols;
+    for (int c = 0; c < 256; ++c) {
+        if (frequencies[c] > 0) symbols.push_back(static_cast<uint8_t>(c));
     }
-    
-    // Create priority queue for Huffman tree construction
-    std::priority_queue<std::shared_ptr<Node>, std::vector<std::shared_ptr<Node>>, CompareNodes> pq;
-    for (const auto& [c, freq] : frequencies) {
-        pq.push(std::make_shared<Node>(c, freq));
+
+    std::vector<size_t> weights(symbols.size());
+    while (true) {
+        std::sort(symbols.begin(), symbols.end(), [&frequencies](uint8_t a, uint8_t b) {
+            return frequencies[a] != frequencies[b] ? frequencies[a] < frequencies[b] : a < b;
+        });
+        for (size_t i = 0; i < symbols.size(); ++i) weights[i] = frequencies[symbols[i]];
+        minimumRedundancyLengths(weights);
+
+        // The lightest symbol has the longest code; a lone symbol still
+        // needs a one-bit code
+        if (weights.front() <= HuffmanCompression::kMaxCodeLength) {
+            CodeLengths lengths{};
+            for (size_t i = 0; i < symbols.size(); ++i) {
+                lengths[symbols[i]] = static_cast<uint8_t>(std::max<size_t>(weights[i], 1));
+            }
+            return lengths;
+        }
+
+        // Too deep: halve the frequencies (keeping every symbol) and retry
+        for (auto& frequency : frequencies) {
+            if (frequency > 0) frequency = (frequency + 1) / 2;
+        }
+    }
+}
+
+// Canonical codes: shorter codes first, ties broken by byte value
+std::array<uint32_t, 256> assignCanonicalCodes(const CodeLengths& lengths) {
+    constexpr int kMaxCodeLength = HuffmanCompression::kMaxCodeLength;
+    uint32_t counts[kMaxCodeLength + 1] = {};
+    for (uint8_t length : lengths) ++counts[length];
+    counts[0] = 0;
+
+    uint32_t next_codes[kMaxCodeLength + 1] = {};
+    uint32_t code = 0;
+    for (int length = 1; length <= kMaxCodeLength; ++length) {
+        code = (code + counts[length - 1]) << 1;
+        next_codes[length] = code;
+    }
+
+    std::array<uint32_t, 256> codes{};
+    for (int c = 0; c < 256; ++c) {
+        if (lengths[c] > 0) codes[c] = next_codes[lengths[c]]++;
     }
+    return codes;
+}
+
+} // namespace
+
+std::vector<unsigned char> HuffmanCompression::compress(const std::string& data) const {
+    return compress(data.data(), data.size());
+}
+
+std::vector<unsigned char> HuffmanCompression::compress(const char* data, size_t size) const {
+    if (size == 0) return {};
     
-    // Build Huffman tree
-    while (pq.size() > 1) {
-        auto left = pq.top(); pq.pop();
-        auto right = pq.top(); pq.pop();
-        pq.push(std::make_shared<Node>(left->frequency + right->frequency, left, right));
+    // Count character frequencies
+    std::array<size_t, 256> frequencies{};
+    for (size_t i = 0; i < size; ++i) {
+        frequencies[static_cast<unsigned char>(data[i])]++;
     }
     
-    root_ = pq.top();
-    encoding_map_.clear();
-    buildEncodingMap(root_, "");
+    CodeLengths lengths = buildCodeLengths(frequencies);
+    std::array<uint32_t, 256> codes = assignCanonicalCodes(lengths);
     
-    // Compress data
-    std::string binary_string;
-    for (char c : data) {
-        binary_string += encoding_map_[c];
+    // The exact output size is known up front, so write in place
+    size_t payload_bits = 0;
+    size_t symbol_count = 0;
+    for (int c = 0; c < 256; ++c) {
+        payload_bits += frequencies[c] * lengths[c];
+        symbol_count += lengths[c] > 0;
     }
+    size_t header_size = 8 + 32 + (symbol_count * kLengthBits + 7) / 8;
+    std::vector<unsigned char> compressed(header_size + (payload_bits + 7) / 8);
     
-    // Convert binary string to bytes
-    std::vector<unsigned char> compressed;
-    compressed.reserve((binary_string.length() + 7) / 8 + sizeof(size_t));
-    
-    // Store original size for decompression
-    size_t original_size = data.length();
-    const unsigned char* size_bytes = reinterpret_cast<const unsigned char*>(&original_size);
-    compressed.insert(compressed.end(), size_bytes, size_bytes + sizeof(size_t));
+    // Header: original size, a bitmap of the bytes that occur, and their
+    // code lengths
+    uint64_t original_size = size;
+    for (int i = 0; i < 8; ++i) {
+        compressed[i] = static_cast<unsigned char>(original_size >> (8 * i));
+    }
+    BitWriter header(compressed.data() + 40);
+    for (int c = 0; c < 256; ++c) {
+        if (lengths[c] == 0) continue;
+        compressed[8 + c / 8] |= static_cast<unsigned char>(1 << (c % 8));
+        header.write(lengths[c], kLengthBits);
+    }
+    header.finish();
     
-    // Convert binary string to bytes
-    for (size_t i = 0; i < binary_string.length(); i += 8) {
-        std::string byte = binary_string.substr(i, 8);
-        byte.append(8 - byte.length(), '0');  // Pad with zeros if needed
-        compressed.push_back(static_cast<unsigned char>(std::bitset<8>(byte).to_ulong()));
+    BitWriter payload(compressed.data() + header_size);
+    for (size_t i = 0; i < size; ++i) {
+        unsigned char symbol = static_cast<unsigned char>(data[i]);
+        payload.write(codes[symbol], lengths[symbol]);
     }
+    payload.finish();
     
     return compressed;
 }
 
-std::string HuffmanCompression::decompress(const std::vector<unsigned char>& compressed_data) {
-    if (compressed_data.size() <= sizeof(size_t)) return "";
+std::string HuffmanCompression::decompress(const std::vector<unsigned char>& compressed_data) const {
+    if (compressed_data.empty()) return "";
+    if (compressed_data.size() < 40) corrupt();
+    
+    uint64_t original_size = 0;
+    for (int i = 0; i < 8; ++i) {
+        original_size |= uint64_t{compressed_data[i]} << (8 * i);
+    }
     
-    // Extract original size
-    size_t original_size;
-    std::memcpy(&original_size, compressed_data.data(), sizeof(size_t));
+    // Every symbol takes at least one bit
+    if (original_size > compressed_data.size() * 8) corrupt();
+    std::string decompressed(original_size, '\0');
+    decompress(compressed_data.data(), compressed_data.size(), decompressed.data(), decompressed.size());
+    return decompressed;
+}
+
+void HuffmanCompression::decompress(const unsigned char* data, size_t size, char* out, size_t out_size) const {
+    if (size == 0 && out_size == 0) return;
+    if (size < 40) corrupt();
     
-    // Convert bytes back to binary string
-    std::string binary_string;
-    for (size_t i = sizeof(size_t); i < compressed_data.size(); ++i) {
-        binary_string += std::bitset<8>(compressed_data[i]).to_string();
+    uint64_t original_size = 0;
+    for (int i = 0; i < 8; ++i) {
+        original_size |= uint64_t{data[i]} << (8 * i);
     }
+    if (original_size != out_size) corrupt();
     
-    // Decompress using Huffman tree
-    std::string decompressed;
-    decompressed.reserve(original_size);
+    size_t symbol_count = 0;
+    for (int i = 8; i < 40; ++i) {
+        symbol_count += std::bitset<8>(data[i]).count();
+    }
+    size_t header_size = 40 + (symbol_count * kLengthBits + 7) / 8;
+    if (symbol_count == 0 || size < header_size) corrupt();
     
-    std::shared_ptr<Node> current = root_;
-    for (char bit : binary_string) {
-        if (decompressed.length() >= original_size) break;
-        
-        if (bit == '0') {
-            current = current->left;
-        } else {
-            current = current->right;
-        }
-        
-        if (!current->left && !current->right) {
-            decompressed += current->character;
-            current = root_;
+    CodeLengths lengths{};
+    BitReader header(data + 40, header_size - 40);
+    for (int c = 0; c < 256; ++c) {
+        if (data[8 + c / 8] & (1 << (c % 8))) {
+            lengths[c] = static_cast<uint8_t>(header.window() >> (64 - kLengthBits));
+            header.skip(kLengthBits);
+            if (lengths[c] == 0) corrupt();
         }
     }
     
-    return decompressed;
+    BitReader reader(data + header_size, size - header_size);
+    CanonicalDecoder(lengths).decode(reader, out, out_size);
+}
+
+uint64_t HuffmanCompression::maxDecodedSize(const unsigned char* data, size_t size) const {
+    if (size < 40) return 0;
+    
+    uint64_t original_size = 0;
+    for (int i = 0; i < 8; ++i) {
+        original_size |= uint64_t{data[i]} << (8 * i);
+    }
+    size_t symbol_count = 0;
+    for (int i = 8; i < 40; ++i) {
+        symbol_count += std::bitset<8>(data[i]).count();
+    }
+    size_t header_size = 40 + (symbol_count * kLengthBits + 7) / 8;
+    if (symbol_count == 0 || size < header_size) return 0;
+    return original_size <= uint64_t{size - header_size} * 8 ? original_size : 0;
 }
 
 bool HuffmanCompression::saveToFile(const std::string& filename, const std::vector<unsigned char>& compressed_data) {
@@ -0,0 +1,408 @@
+#include "IndexSegment.hpp"
+#include "StreamVByte.hpp"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+constexpr char kSegmentMagic[8] = {'A', 'P', 'S', 'S', 'E', 'G', 'M', 'T'};
+
+using BlockInfo = PostingList::BlockInfo;
+using Posting = PostingList::Posting;
+
+// Outcomes of checking a term's postings
+constexpr uint8_t kUnchecked = 0;
+constexpr uint8_t kValid = 1;
+constexpr uint8_t kDamaged = 2;
+
+[[noreturn]] void corrupt() {
+    throw std::runtime_error("Corrupt index segment");
+}
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Whether count StreamVByte values starting at begin end by end
+bool fits(const uint8_t* data, size_t begin, size_t end, size_t count) {
+    return begin <= end && (count + 3) / 4 <= end - begin &&
+           StreamVByte::encodedSize(data + begin, count) <= end - begin;
+}
+
+// Byte sizes of a term's postings layout
+struct PostingsLayout {
+    size_t num_blocks;
+    size_t tail_size;
+    size_t data_offset;     // Relative to the term's postings
+    size_t tail_offset;
+    size_t impacts_offset;
+    size_t position_offsets_offset;
+    size_t positions_offset;
+    size_t end;
+
+    PostingsLayout(size_t size, size_t data_size, bool has_impacts, bool has_positions, size_t positions_size) {
+        num_blocks = (size + PostingList::kBlockSize - 1) / PostingList::kBlockSize;
+        tail_size = size % PostingList::kBlockSize;
+        data_offset = num_blocks * sizeof(BlockInfo);
+        tail_offset = alignUp(data_offset + data_size, alignof(Posting));
+        impacts_offset = tail_offset + tail_size * sizeof(Posting);
+        end = impacts_offset + (has_impacts ? size : 0);
+        position_offsets_offset = alignUp(end, alignof(uint32_t));
+        positions_offset = position_offsets_offset + (size + 1) * sizeof(uint32_t);
+        if (has_positions) {
+            end = positions_offset + positions_size;
+        }
+    }
+};
+
+} // namespace
+
+IndexSegment::IndexSegment(std::shared_ptr<const void> owner, const char* data, size_t size)
+    : owner_(std::move(owner)), data_(data), size_(size) {
+    if (size < sizeof(Header) || reinterpret_cast<uintptr_t>(data) % alignof(Header) != 0) {
+        corrupt();
+    }
+    header_ = reinterpret_cast<const Header*>(data);
+    if (std::memcmp(header_->magic, kSegmentMagic, sizeof(kSegmentMagic)) != 0 ||
+        header_->version != kFormatVersion || header_->size > size) {
+        corrupt();
+    }
+    size_ = header_->size;
+
+    const Header& h = *header_;
+    bool valid = h.terms_offset >= sizeof(Header) && h.terms_offset % alignof(TermEntry) == 0 &&
+                 h.terms_offset + uint64_t{h.term_count} * sizeof(TermEntry) <= h.dictionary_offset &&
+                 h.dictionary_offset % 8 == 0 && h.dictionary_offset <= h.postings_offset &&
+                 h.postings_offset % 8 == 0 &&
+                 h.postings_offset <= h.documents_offset && h.documents_offset % alignof(DocumentEntry) == 0 &&
+                 h.documents_offset + uint64_t{h.doc_count} * sizeof(DocumentEntry) <= h.document_order_offset &&
+                 h.document_order_offset % alignof(uint32_t) == 0 &&
+                 h.document_order_offset + uint64_t{h.doc_count} * sizeof(uint32_t) <= h.document_strings_offset &&
+                 h.document_strings_offset <= size_;
+    if (!valid) {
+        corrupt();
+    }
+
+    terms_ = reinterpret_cast<const TermEntry*>(data + h.terms_offset);
+    dictionary_ = TermDictionary(owner_, data + h.dictionary_offset, h.postings_offset - h.dictionary_offset);
+    if (dictionary_.size() != h.term_count) {
+        corrupt();
+    }
+    postings_ = std::string_view(data + h.postings_offset, h.documents_offset - h.postings_offset);
+    documents_ = reinterpret_cast<const DocumentEntry*>(data + h.documents_offset);
+    document_order_ = reinterpret_cast<const uint32_t*>(data + h.document_order_offset);
+    document_strings_ = std::string_view(data + h.document_strings_offset, size_ - h.document_strings_offset);
+    term_states_.reset(new std::atomic<uint8_t>[h.term_count]());
+}
+
+bool IndexSegment::checkTerm(uint32_t term_id) const {
+    // Racing first lookups both check and store the same outcome
+    uint8_t state = term_states_[term_id].load(std::memory_order_acquire);
+    if (state == kUnchecked) {
+        state = validatePostings(term_id) ? kValid : kDamaged;
+        term_states_[term_id].store(state, std::memory_order_release);
+    }
+    return state == kValid;
+}
+
+bool IndexSegment::validatePostings(uint32_t term_id) const {
+    const TermEntry& entry = terms_[term_id];
+    PostingsLayout layout(entry.size, entry.data_size, hasImpacts(), hasPositions(), entry.positions_size);
+    if (entry.size == 0 || entry.size > header_->doc_count || entry.postings_offset % alignof(BlockInfo) != 0 ||
+        entry.postings_offset > postings_.size() || layout.end > postings_.size() - entry.postings_offset) {
+        return false;
+    }
+
+    // Decode every block: doc IDs must rise and stay in the segment, and
+    // the block and term maxima must bound what they summarize
+    PostingList::View view = getPostings(term_id);
+    PositionList::View positions = getPositions(term_id);
+    uint32_t doc_ids[PostingList::kBlockSize];
+    uint32_t term_frequencies[PostingList::kBlockSize];
+    size_t sealed = view.num_blocks - (view.tail_size > 0 ? 1 : 0);
+    size_t index = 0;
+    uint32_t previous = 0;
+    for (size_t b = 0; b < view.num_blocks; ++b) {
+        const BlockInfo& block = view.blocks[b];
+        size_t count = view.blockSize(b);
+        if (b < sealed && (!fits(view.data, block.doc_offset, block.tf_offset, count) ||
+                           !fits(view.data, block.tf_offset, entry.data_size, count))) {
+            return false;
+        }
+        view.decodeDocIds(b, doc_ids);
+        view.decodeTermFrequencies(b, term_frequencies);
+
+        uint32_t max_term_frequency = 0;
+        for (size_t i = 0; i < count; ++i, ++index) {
+            if (doc_ids[i] >= header_->doc_count || (index > 0 && doc_ids[i] <= previous) ||
+                term_frequencies[i] == 0) {
+                return false;
+            }
+            previous = doc_ids[i];
+            max_term_frequency = std::max(max_term_frequency, term_frequencies[i]);
+
+            if (hasPositions()) {
+                uint32_t begin = positions.offsets[index];
+                uint32_t end = positions.offsets[index + 1];
+                if (end > entry.positions_size || !fits(positions.data, begin, end, term_frequencies[i])) {
+                    return false;
+                }
+            }
+        }
+        if (block.last_doc_id != doc_ids[count - 1] || block.max_term_frequency < max_term_frequency ||
+            entry.max_term_frequency < max_term_frequency) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void IndexSegment::write(const InvertedIndex& index, BinaryWriter& writer) {
+    const bool has_impacts = index.hasImpacts();
+    const bool has_positions = index.hasPositions();
+    const uint32_t term_count = static_cast<uint32_t>(index.getTermCount());
+    const uint32_t doc_count = static_cast<uint32_t>(index.getTotalDocuments());
+
+    // Terms in byte order, so IDs match the dictionary's
+    std::vector<uint32_t> sorted_terms(term_count);
+    std::iota(sorted_terms.begin(), sorted_terms.end(), 0);
+    std::sort(sorted_terms.begin(), sorted_terms.end(), [&index](uint32_t a, uint32_t b) {
+        return index.getTerm(a) < index.getTerm(b);
+    });
+
+    std::vector<std::string_view> term_names;
+    term_names.reserve(term_count);
+    for (uint32_t term_id : sorted_terms) {
+        term_names.push_back(index.getTerm(term_id));
+    }
+    BinaryWriter dictionary;
+    TermDictionary::write(term_names, nullptr, dictionary);
+
+    BinaryWriter terms, postings;
+    for (uint32_t term_id : sorted_terms) {
+        PostingList::View view = index.getPostings(term_id).view();
+        size_t data_size = static_cast<size_t>(view.data_end - view.data);
+
+        postings.align(alignof(BlockInfo));
+        TermEntry entry{};
+        entry.postings_offset = postings.size();
+        entry.size = static_cast<uint32_t>(view.size);
+        entry.data_size = static_cast<uint32_t>(data_size);
+        entry.max_term_frequency = index.getMaxTermFrequency(term_id);
+        PositionList::View positions = index.getPositions(term_id).view();
+        if (has_positions) {
+            entry.positions_size = static_cast<uint32_t>(positions.data_end - positions.data);
+        }
+        terms.write(entry);
+
+        postings.writeBytes(view.blocks, view.num_blocks * sizeof(BlockInfo));
+        postings.writeBytes(view.data, data_size);
+        postings.align(alignof(Posting));
+        postings.writeBytes(view.tail, view.tail_size * sizeof(Posting));
+        if (has_impacts) {
+            postings.writeBytes(index.getImpacts(term_id).data(), view.size);
+        }
+        if (has_positions) {
+            postings.align(alignof(uint32_t));
+            postings.writeBytes(positions.offsets, (positions.size + 1) * sizeof(uint32_t));
+            postings.writeBytes(positions.data, entry.positions_size);
+        }
+    }
+
+    std::vector<uint32_t> document_order(doc_count);
+    std::iota(document_order.begin(), document_order.end(), 0);
+    std::sort(document_order.begin(), document_order.end(), [&index](uint32_t a, uint32_t b) {
+        return index.getDocument(a).id < index.getDocument(b).id;
+    });
+
+    BinaryWriter documents, document_strings;
+    for (uint32_t doc_id = 0; doc_id < doc_count; ++doc_id) {
+        const auto& document = index.getDocument(doc_id);
+        DocumentEntry entry{};
+        entry.id_offset = static_cast<uint32_t>(document_strings.size());
+        entry.id_length = static_cast<uint32_t>(document.id.size());
+        document_strings.writeBytes(document.id.data(), document.id.size());
+        entry.path_offset = static_cast<uint32_t>(document_strings.size());
+        entry.path_length = static_cast<uint32_t>(document.path.size());
+        document_strings.writeBytes(document.path.data(), document.path.size());
+        documents.write(entry);
+    }
+
+    // Lay the sections out after the header
+    Header header{};
+    std::memcpy(header.magic, kSegmentMagic, sizeof(kSegmentMagic));
+    header.version = kFormatVersion;
+    header.flags = (has_impacts ? kHasImpacts : 0) | (has_positions ? kHasPositions : 0);
+    header.term_count = term_count;
+    header.doc_count = doc_count;
+    size_t offset = sizeof(Header);
+    auto place = [&offset](size_t bytes) {
+        offset = alignUp(offset, 8);
+        size_t start = offset;
+        offset += bytes;
+        return start;
+    };
+    header.terms_offset = place(terms.size());
+    header.dictionary_offset = place(dictionary.size());
+    header.postings_offset = place(postings.size());
+    header.documents_offset = place(documents.size());
+    header.document_order_offset = place(document_order.size() * sizeof(uint32_t));
+    header.document_strings_offset = place(document_strings.size());
+    header.size = offset;
+
+    writer.align(8);
+    size_t start = writer.size();
+    auto append = [&writer, start](uint64_t section_offset, const void* bytes, size_t size) {
+        writer.padTo(start + section_offset);
+        writer.writeBytes(bytes, size);
+    };
+    writer.write(header);
+    append(header.terms_offset, terms.data().data(), terms.size());
+    append(header.dictionary_offset, dictionary.data().data(), dictionary.size());
+    append(header.postings_offset, postings.data().data(), postings.size());
+    append(header.documents_offset, documents.data().data(), documents.size());
+    append(header.document_order_offset, document_order.data(), document_order.size() * sizeof(uint32_t));
+    append(header.document_strings_offset, document_strings.data().data(), document_strings.size());
+}
+
+std::shared_ptr<const IndexSegment> IndexSegment::fromIndex(const InvertedIndex& index) {
+    BinaryWriter writer;
+    write(index, writer);
+    auto bytes = std::make_shared<const std::string>(writer.data());
+    return std::make_shared<const IndexSegment>(bytes, bytes->data(), bytes->size());
+}
+
+std::shared_ptr<const IndexSegment> IndexSegment::merge(
+        const std::vector<std::shared_ptr<const IndexSegment>>& segments, bool store_impacts) {
+    // Replay each segment as a partial index; appending keeps postings in
+    // document order, so the lists are re-blocked without sorting
+    const bool store_positions = std::all_of(segments.begin(), segments.end(), [](const auto& segment) {
+        return segment->hasPositions();
+    });
+    InvertedIndex index;
+    index.setStoreImpacts(store_impacts);
+    index.setStorePositions(store_positions);
+    uint32_t doc_ids[PostingList::kBlockSize];
+    uint32_t term_frequencies[PostingList::kBlockSize];
+    for (const auto& segment : segments) {
+        InvertedIndex::PartialIndex partial;
+        partial.store_positions = store_positions;
+        partial.documents.reserve(segment->getTotalDocuments());
+        for (uint32_t doc_id = 0; doc_id < segment->getTotalDocuments(); ++doc_id) {
+            partial.documents.push_back({std::string(segment->getDocumentId(doc_id)),
+                                         std::string(segment->getDocumentPath(doc_id))});
+        }
+
+        // Merging reads everything, so check everything first
+        segment->getDictionary().validate();
+        segment->getDictionary().forEach([&](std::string_view term_name, uint32_t term_id) {
+            if (!segment->checkTerm(term_id)) corrupt();
+            PostingList::View view = segment->getPostings(term_id);
+            PositionList::View positions = segment->getPositions(term_id);
+            std::string term(term_name);
+            auto& postings = partial.postings[term];
+            postings.reserve(view.size);
+            for (size_t b = 0; b < view.num_blocks; ++b) {
+                size_t count = view.decodeDocIds(b, doc_ids);
+                view.decodeTermFrequencies(b, term_frequencies);
+                for (size_t i = 0; i < count; ++i) {
+                    postings.push_back({doc_ids[i], term_frequencies[i]});
+                }
+            }
+
+            if (store_positions) {
+                auto& term_positions = partial.positions[term];
+                for (size_t i = 0; i < postings.size(); ++i) {
+                    size_t offset = term_positions.size();
+                    term_positions.resize(offset + postings[i].term_frequency);
+                    positions.decode(i, postings[i].term_frequency, term_positions.data() + offset);
+                }
+            }
+        });
+        index.mergePartial(partial);
+    }
+    return fromIndex(index);
+}
+
+uint32_t IndexSegment::getTermId(std::string_view term) const {
+    // A damaged dictionary or term entry hides the term
+    uint32_t term_id;
+    try {
+        term_id = dictionary_.find(term);
+    }
+    catch (const std::runtime_error&) {
+        return InvertedIndex::kInvalidId;
+    }
+    if (term_id >= getTermCount() || !checkTerm(term_id)) {
+        return InvertedIndex::kInvalidId;
+    }
+    return term_id;
+}
+
+PostingList::View IndexSegment::getPostings(uint32_t term_id) const {
+    const TermEntry& entry = terms_[term_id];
+    PostingsLayout layout(entry.size, entry.data_size, hasImpacts(), hasPositions(), entry.positions_size);
+    const char* base = postings_.data() + entry.postings_offset;
+    PostingList::View view;
+    view.blocks = reinterpret_cast<const BlockInfo*>(base);
+    view.num_blocks = layout.num_blocks;
+    view.data = reinterpret_cast<const uint8_t*>(base + layout.data_offset);
+    view.data_end = view.data + entry.data_size;
+    view.tail = reinterpret_cast<const Posting*>(base + layout.tail_offset);
+    view.tail_size = layout.tail_size;
+    view.size = entry.size;
+    return view;
+}
+
+const uint8_t* IndexSegment::getImpacts(uint32_t term_id) const {
+    if (!hasImpacts()) return nullptr;
+
+    const TermEntry& entry = terms_[term_id];
+    PostingsLayout layout(entry.size, entry.data_size, true, hasPositions(), entry.positions_size);
+    return reinterpret_cast<const uint8_t*>(postings_.data() + entry.postings_offset + layout.impacts_offset);
+}
+
+PositionList::View IndexSegment::getPositions(uint32_t term_id) const {
+    if (!hasPositions()) return {};
+
+    const TermEntry& entry = terms_[term_id];
+    PostingsLayout layout(entry.size, entry.data_size, hasImpacts(), true, entry.positions_size);
+    const char* base = postings_.data() + entry.postings_offset;
+    PositionList::View view;
+    view.offsets = reinterpret_cast<const uint32_t*>(base + layout.position_offsets_offset);
+    view.data = reinterpret_cast<const uint8_t*>(base + layout.positions_offset);
+    view.data_end = view.data + entry.positions_size;
+    view.size = entry.size;
+    return view;
+}
+
+std::string_view IndexSegment::getDocumentId(uint32_t doc_id) const {
+    const DocumentEntry& entry = documents_[doc_id];
+    if (uint64_t{entry.id_offset} + entry.id_length > document_strings_.size()) {
+        return {};
+    }
+    return document_strings_.substr(entry.id_offset, entry.id_length);
+}
+
+std::string_view IndexSegment::getDocumentPath(uint32_t doc_id) const {
+    const DocumentEntry& entry = documents_[doc_id];
+    if (uint64_t{entry.path_offset} + entry.path_length > document_strings_.size()) {
+        return {};
+    }
+    return document_strings_.substr(entry.path_offset, entry.path_length);
+}
+
+uint32_t IndexSegment::findDocument(std::string_view id) const {
+    const uint32_t* begin = document_order_;
+    const uint32_t* end = document_order_ + header_->doc_count;
+    const uint32_t* it = std::lower_bound(begin, end, id, [this](uint32_t doc_id, std::string_view key) {
+        return doc_id < header_->doc_count && getDocumentId(doc_id) < key;
+    });
+    if (it != end && *it < header_->doc_count && getDocumentId(*it) == id) {
+        return *it;
+    }
+    return InvertedIndex::kInvalidId;
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#include "IndexSnapshot.hpp"
+#include <algorithm>
+#include <cmath>
+
+IndexSnapshot::IndexSnapshot(SegmentList segments, const SegmentList& buffer_chunks, const InvertedIndex& index,
+                             uint64_t generation)
+    : segments_(std::move(segments)), buffer_chunk_count_(buffer_chunks.size()), index_(index), tfidf_(index_),
+      total_documents_(0), generation_(generation) {
+    segments_.insert(segments_.end(), buffer_chunks.begin(), buffer_chunks.end());
+    bases_.reserve(segments_.size() + 1);
+    for (const auto& segment : segments_) {
+        bases_.push_back(static_cast<uint32_t>(total_documents_));
+        total_documents_ += segment->getTotalDocuments();
+    }
+    bases_.push_back(static_cast<uint32_t>(total_documents_));
+    total_documents_ += index_.getTotalDocuments();
+    log_total_documents_ = std::log(static_cast<double>(total_documents_));
+}
+
+double IndexSnapshot::lookupTerm(std::string_view term, std::vector<TermPostings>& postings) const {
+    const bool use_impacts = index_.hasImpacts();
+    size_t document_frequency = 0;
+
+    for (size_t part = 0; part < segments_.size(); ++part) {
+        const IndexSegment& segment = *segments_[part];
+        uint32_t term_id = segment.getTermId(term);
+        if (term_id == InvertedIndex::kInvalidId) continue;
+
+        document_frequency += segment.getDocumentFrequency(term_id);
+        postings.push_back({part, bases_[part], segment.getPostings(term_id),
+                            use_impacts ? segment.getImpacts(term_id) : nullptr,
+                            segment.getMaxTermFrequency(term_id), segment.getPositions(term_id)});
+    }
+
+    uint32_t term_id = index_.getTermId(term);
+    if (term_id != InvertedIndex::kInvalidId) {
+        document_frequency += index_.getPostings(term_id).size();
+        postings.push_back({segments_.size(), bases_.back(), index_.getPostings(term_id).view(),
+                            use_impacts ? index_.getImpacts(term_id).data() : nullptr,
+                            index_.getMaxTermFrequency(term_id),
+                            index_.hasPositions() ? index_.getPositions(term_id).view() : PositionList::View()});
+
+        // Without segments the index's cached statistics are the whole story
+        if (segments_.empty()) {
+            return tfidf_.getCachedIDF(term_id);
+        }
+    }
+
+    if (document_frequency == 0) return 0.0;
+    return log_total_documents_ - std::log(static_cast<double>(document_frequency));
+}
+
+std::string_view IndexSnapshot::getDocumentId(uint32_t doc_id) const {
+    // The last part whose base is not past doc_id holds it
+    size_t part = static_cast<size_t>(std::upper_bound(bases_.begin(), bases_.end(), doc_id) - bases_.begin()) - 1;
+    if (part == segments_.size()) {
+        return index_.getDocument(doc_id - bases_[part]).id;
+    }
+    return segments_[part]->getDocumentId(doc_id - bases_[part]);
+}
+
+bool IndexSnapshot::containsDocument(std::string_view id) const {
+    if (index_.containsDocument(std::string(id))) return true;
+    for (const auto& segment : segments_) {
+        if (segment->findDocument(id) != InvertedIndex::kInvalidId) return true;
+    }
+    return false;
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include "Intersection.hpp"
+#include "CpuFeatures.hpp"
+#include <algorithm>
+
+#ifdef SEARCH_ENGINE_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+size_t mergeScalar(const uint32_t* a, size_t a_size, const uint32_t* b, size_t b_size, uint32_t* out,
+                   size_t i = 0, size_t j = 0, size_t count = 0) {
+    while (i < a_size && j < b_size) {
+        if (a[i] < b[j]) {
+            ++i;
+        }
+        else if (b[j] < a[i]) {
+            ++j;
+        }
+        else {
+            out[count++] = a[i];
+            ++i;
+            ++j;
+        }
+    }
+    return count;
+}
+
+#ifdef SEARCH_ENGINE_X86
+
+SEARCH_ENGINE_TARGET("sse2")
+size_t mergeSSE2(const uint32_t* a, size_t a_size, const uint32_t* b, size_t b_size, uint32_t* out) {
+    size_t i = 0;
+    size_t j = 0;
+    size_t count = 0;
+    while (i + 4 <= a_size && j + 4 <= b_size) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + j));
+
+        // Compare all 16 pairs by rotating b's four values past a's
+        __m128i equal = _mm_cmpeq_epi32(va, vb);
+        equal = _mm_or_si128(equal, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1))));
+        equal = _mm_or_si128(equal, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2))));
+        equal = _mm_or_si128(equal, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3))));
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(equal));
+
+        for (int lane = 0; lane < 4; ++lane) {
+            if (mask & (1 << lane)) out[count++] = a[i + lane];
+        }
+
+        // Advance past the block with the smaller maximum, or both
+        uint32_t a_max = a[i + 3];
+        uint32_t b_max = b[j + 3];
+        if (a_max <= b_max) i += 4;
+        if (b_max <= a_max) j += 4;
+    }
+    return mergeScalar(a, a_size, b, b_size, out, i, j, count);
+}
+
+#endif // SEARCH_ENGINE_X86
+
+} // namespace
+
+size_t Intersection::intersect(const uint32_t* a, size_t a_size, const uint32_t* b, size_t b_size, uint32_t* out) {
+    if (a_size == 0 || b_size == 0) return 0;
+    if (a_size * kGallopRatio < b_size) {
+        return gallop(a, a_size, b, b_size, out);
+    }
+    if (b_size * kGallopRatio < a_size) {
+        return gallop(b, b_size, a, a_size, out);
+    }
+    return merge(a, a_size, b, b_size, out);
+}
+
+size_t Intersection::gallop(const uint32_t* small, size_t small_size, const uint32_t* large, size_t large_size,
+                            uint32_t* out) {
+    size_t count = 0;
+    size_t low = 0;
+    for (size_t i = 0; i < small_size && low < large_size; ++i) {
+        uint32_t target = small[i];
+
+        // Double the step until it passes target, then search that range
+        size_t step = 1;
+        size_t high = low;
+        while (high < large_size && large[high] < target) {
+            low = high + 1;
+            high += step;
+            step *= 2;
+        }
+        high = std::min(high + 1, large_size);
+        low = static_cast<size_t>(std::lower_bound(large + low, large + high, target) - large);
+        if (low < large_size && large[low] == target) {
+            out[count++] = target;
+            ++low;
+        }
+    }
+    return count;
+}
+
+size_t Intersection::merge(const uint32_t* a, size_t a_size, const uint32_t* b, size_t b_size, uint32_t* out) {
+#ifdef SEARCH_ENGINE_X86
+    static const bool use_sse2 = CpuFeatures::hasSSE2();
+    if (use_sse2) {
+        return mergeSSE2(a, a_size, b, b_size, out);
+    }
+#endif
+    return mergeScalar(a, a_size, b, b_size, out);
+}
\ No newline at end of file
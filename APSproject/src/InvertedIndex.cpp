@@ -1,24 +1,185 @@
 #include "InvertedIndex.hpp"
+#include "TFIDFCalculator.hpp"
+#include <stdexcept>
+#include <cmath>
 
-void InvertedIndex::addDocument(const std::shared_ptr<Document>& doc) {
-    // Get word frequencies from the document
-    const auto& frequencies = doc->getWordFrequencies();
-    
-    // Add each word to the inverted index
-    for (const auto& [word, frequency] : frequencies) {
-        index_[word].emplace_back(doc->getId(), frequency);
+InvertedIndex::InvertedIndex(const InvertedIndex& other)
+    : terms_(other.terms_),
+      postings_(other.postings_),
+      log_document_frequencies_(other.log_document_frequencies_),
+      log_total_documents_(other.log_total_documents_),
+      store_impacts_(other.store_impacts_),
+      store_positions_(other.store_positions_),
+      documents_(other.documents_),
+      document_ids_(other.document_ids_) {
+    term_ids_.reserve(terms_.size());
+    for (uint32_t term_id = 0; term_id < terms_.size(); ++term_id) {
+        term_ids_.emplace(terms_[term_id], term_id);
     }
-    
-    total_documents_++;
 }
 
-const std::vector<InvertedIndex::PostingInfo>& InvertedIndex::getPostings(const std::string& term) const {
-    static const std::vector<PostingInfo> empty_vector;
-    auto it = index_.find(term);
-    return (it != index_.end()) ? it->second : empty_vector;
+InvertedIndex& InvertedIndex::operator=(const InvertedIndex& other) {
+    if (this != &other) {
+        *this = InvertedIndex(other);
+    }
+    return *this;
+}
+
+uint32_t InvertedIndex::addDocument(const std::shared_ptr<Document>& doc) {
+    if (document_ids_.count(doc->getId())) {
+        throw std::invalid_argument("Duplicate document id: " + doc->getId());
+    }
+
+    if (store_positions_ && !doc->hasPositions()) {
+        throw std::invalid_argument("Document parsed without positions: " + doc->getId());
+    }
+
+    uint32_t doc_id = addDocumentEntry({doc->getId(), doc->getPath()});
+
+    // Add each word to the inverted index. Document IDs grow monotonically,
+    // so appending keeps every posting list sorted.
+    for (const auto& [word, occurrences] : doc->getWordOccurrences()) {
+        appendPosting(addTerm(word), {doc_id, occurrences.frequency}, occurrences.positions.data());
+    }
+
+    return doc_id;
+}
+
+void InvertedIndex::PartialIndex::addDocument(const Document& doc) {
+    if (store_positions && !doc.hasPositions()) {
+        throw std::invalid_argument("Document parsed without positions: " + doc.getId());
+    }
+
+    uint32_t local_id = static_cast<uint32_t>(documents.size());
+    documents.push_back({doc.getId(), doc.getPath()});
+    for (const auto& [word, occurrences] : doc.getWordOccurrences()) {
+        std::string term(word);
+        postings[term].push_back({local_id, occurrences.frequency});
+        if (store_positions) {
+            auto& term_positions = positions[term];
+            term_positions.insert(term_positions.end(), occurrences.positions.begin(), occurrences.positions.end());
+        }
+    }
+}
+
+void InvertedIndex::mergePartial(const PartialIndex& partial) {
+    for (const auto& entry : partial.documents) {
+        if (document_ids_.count(entry.id)) {
+            throw std::invalid_argument("Duplicate document id: " + entry.id);
+        }
+    }
+    if (store_positions_ && !partial.store_positions) {
+        throw std::invalid_argument("Partial index has no positions");
+    }
+
+    uint32_t base = static_cast<uint32_t>(documents_.size());
+    for (const auto& entry : partial.documents) {
+        addDocumentEntry(entry);
+    }
+
+    // Partial postings are sorted by local ID and every merged document is
+    // newer than the indexed ones, so each list is extended in order
+    for (const auto& [term, postings] : partial.postings) {
+        uint32_t term_id = addTerm(term);
+        const uint32_t* positions = store_positions_ ? partial.positions.at(term).data() : nullptr;
+        for (const auto& posting : postings) {
+            appendPosting(term_id, {base + posting.doc_id, posting.term_frequency}, positions);
+            if (positions) positions += posting.term_frequency;
+        }
+    }
+}
+
+uint32_t InvertedIndex::addTerm(std::string_view term) {
+    auto it = term_ids_.find(term);
+    if (it != term_ids_.end()) {
+        return it->second;
+    }
+
+    uint32_t term_id = static_cast<uint32_t>(terms_.size());
+    terms_.emplace_back(term);
+    term_ids_.emplace(terms_.back(), term_id);
+    postings_.push_back(std::make_shared<TermPostings>());
+    log_document_frequencies_.push_back(0.0);
+    return term_id;
+}
+
+uint32_t InvertedIndex::addDocumentEntry(const DocumentEntry& entry) {
+    uint32_t doc_id = static_cast<uint32_t>(documents_.size());
+    documents_.push_back(entry);
+    document_ids_.emplace(entry.id, doc_id);
+    log_total_documents_ = std::log(static_cast<double>(documents_.size()));
+    return doc_id;
+}
+
+InvertedIndex::TermPostings& InvertedIndex::mutablePostings(uint32_t term_id) {
+    // Copies are only made by the thread that modifies this index, so a
+    // count of one cannot grow behind our back
+    auto& shared = postings_[term_id];
+    if (shared.use_count() > 1) {
+        shared = std::make_shared<TermPostings>(*shared);
+    }
+    return *shared;
+}
+
+void InvertedIndex::appendPosting(uint32_t term_id, const Posting& posting, const uint32_t* positions) {
+    TermPostings& term = mutablePostings(term_id);
+    term.postings.append(posting);
+    log_document_frequencies_[term_id] = std::log(static_cast<double>(term.postings.size()));
+
+    if (store_impacts_) {
+        term.impacts.push_back(TFIDFCalculator::quantizeTF(posting.term_frequency));
+    }
+    if (store_positions_) {
+        term.positions.append(positions, posting.term_frequency);
+    }
+}
+
+void InvertedIndex::setStoreImpacts(bool enabled) {
+    if (enabled == store_impacts_) return;
+    store_impacts_ = enabled;
+
+    for (uint32_t term_id = 0; term_id < postings_.size(); ++term_id) {
+        TermPostings& term = mutablePostings(term_id);
+        term.impacts.clear();
+        if (enabled) {
+            term.impacts.reserve(term.postings.size());
+            for (const auto& posting : term.postings.decode()) {
+                term.impacts.push_back(TFIDFCalculator::quantizeTF(posting.term_frequency));
+            }
+        }
+        else {
+            term.impacts.shrink_to_fit();
+        }
+    }
+}
+
+void InvertedIndex::setStorePositions(bool enabled) {
+    if (enabled == store_positions_) return;
+    if (enabled && !documents_.empty()) {
+        throw std::logic_error("Positions can only be enabled on an empty index");
+    }
+    store_positions_ = enabled;
+
+    for (uint32_t term_id = 0; term_id < postings_.size(); ++term_id) {
+        mutablePostings(term_id).positions = PositionList();
+    }
+}
+
+uint32_t InvertedIndex::getTermId(std::string_view term) const {
+    auto it = term_ids_.find(term);
+    return (it != term_ids_.end()) ? it->second : kInvalidId;
+}
+
+const PostingList& InvertedIndex::getPostings(const std::string& term) const {
+    static const PostingList empty_list;
+    uint32_t term_id = getTermId(term);
+    return (term_id != kInvalidId) ? postings_[term_id]->postings : empty_list;
 }
 
 size_t InvertedIndex::getDocumentFrequency(const std::string& term) const {
-    auto it = index_.find(term);
-    return (it != index_.end()) ? it->second.size() : 0;
-} 
\ No newline at end of file
+    return getPostings(term).size();
+}
+
+bool InvertedIndex::containsDocument(const std::string& id) const {
+    return document_ids_.find(id) != document_ids_.end();
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#include "LevenshteinAutomaton.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+LevenshteinAutomaton::LevenshteinAutomaton(std::string_view word, size_t max_distance)
+    : word_(word), max_distance_(max_distance) {
+    if (max_distance >= UINT8_MAX) {
+        throw std::invalid_argument("Maximum edit distance is too large");
+    }
+}
+
+LevenshteinAutomaton::State LevenshteinAutomaton::start() const {
+    // Reaching prefix j of the word from empty input takes j insertions
+    State state(word_.size() + 1);
+    for (size_t j = 0; j < state.size(); ++j) {
+        state[j] = static_cast<uint8_t>(std::min(j, max_distance_ + 1));
+    }
+    return state;
+}
+
+LevenshteinAutomaton::State LevenshteinAutomaton::step(const State& state, unsigned char c) const {
+    State next;
+    step(state, c, next);
+    return next;
+}
+
+void LevenshteinAutomaton::step(const State& state, unsigned char c, State& next) const {
+    const unsigned limit = static_cast<unsigned>(max_distance_ + 1);
+    next.resize(state.size());
+    next[0] = static_cast<uint8_t>(std::min(state[0] + 1u, limit));
+    for (size_t j = 1; j < state.size(); ++j) {
+        unsigned substitute = state[j - 1] + (static_cast<unsigned char>(word_[j - 1]) == c ? 0u : 1u);
+        unsigned remove = state[j] + 1u;
+        unsigned insert = next[j - 1] + 1u;
+        next[j] = static_cast<uint8_t>(std::min({substitute, remove, insert, limit}));
+    }
+}
+
+size_t LevenshteinAutomaton::lowestDistance(const State& state) const {
+    return *std::min_element(state.begin(), state.end());
+}
\ No newline at end of file
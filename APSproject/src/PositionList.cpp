@@ -0,0 +1,34 @@
+#include "PositionList.hpp"
+#include "StreamVByte.hpp"
+#include <stdexcept>
+
+void PositionList::View::decode(size_t index, size_t count, uint32_t* positions) const {
+    uint32_t begin = offsets[index];
+    uint32_t end = offsets[index + 1];
+    if (begin > end || data + end > data_end || (count + 3) / 4 > end - begin ||
+        StreamVByte::encodedSize(data + begin, count) > end - begin) {
+        throw std::runtime_error("Corrupt position list");
+    }
+    StreamVByte::decodeDelta(data + begin, count, 0, positions, data + end);
+}
+
+void PositionList::append(const uint32_t* positions, size_t count) {
+    size_t offset = data_.size();
+    data_.resize(offset + StreamVByte::maxEncodedSize(count));
+    offset += StreamVByte::encodeDelta(positions, count, 0, data_.data() + offset);
+    data_.resize(offset);
+    offsets_.push_back(static_cast<uint32_t>(offset));
+}
+
+size_t PositionList::memoryUsage() const {
+    return offsets_.capacity() * sizeof(uint32_t) + data_.capacity();
+}
+
+PositionList::View PositionList::view() const {
+    View v;
+    v.offsets = offsets_.data();
+    v.data = data_.data();
+    v.data_end = data_.data() + data_.size();
+    v.size = size();
+    return v;
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include "PostingCursor.hpp"
+#include <algorithm>
+
+PostingCursor::PostingCursor(const PostingList::View& list, const uint8_t* impacts)
+    : list_(list), impacts_(impacts) {
+    loadBlock(0);
+}
+
+void PostingCursor::loadBlock(size_t b) {
+    block_ = b;
+    shallow_block_ = std::max(shallow_block_, b);
+    pos_ = 0;
+    term_frequencies_decoded_ = false;
+
+    if (b >= list_.num_blocks) {
+        count_ = 0;
+        doc_id_ = kEnd;
+        return;
+    }
+    count_ = list_.decodeDocIds(b, doc_ids_);
+    doc_id_ = doc_ids_[0];
+}
+
+uint32_t PostingCursor::termFrequency() {
+    if (!term_frequencies_decoded_) {
+        list_.decodeTermFrequencies(block_, term_frequencies_);
+        term_frequencies_decoded_ = true;
+    }
+    return term_frequencies_[pos_];
+}
+
+void PostingCursor::nextGEQ(uint32_t target) {
+    if (doc_id_ >= target) return;
+
+    // Skip whole blocks using their last document ID without decoding them
+    shallowAdvance(target);
+    if (shallow_block_ != block_) {
+        loadBlock(shallow_block_);
+        if (doc_id_ >= target) return;
+    }
+
+    // The block's last document is >= target, so the search stays in range
+    const uint32_t* it = std::lower_bound(doc_ids_ + pos_, doc_ids_ + count_, target);
+    pos_ = static_cast<size_t>(it - doc_ids_);
+    doc_id_ = doc_ids_[pos_];
+}
+
+void PostingCursor::shallowAdvance(uint32_t target) {
+    // Targets normally only grow; if one falls behind the shallow block,
+    // restart from the decoded block so the reported bounds cover target
+    if (shallow_block_ > block_ && list_.blocks[shallow_block_ - 1].last_doc_id >= target) {
+        shallow_block_ = block_;
+    }
+    while (shallow_block_ < list_.num_blocks && list_.blocks[shallow_block_].last_doc_id < target) {
+        ++shallow_block_;
+    }
+}
+
+uint32_t PostingCursor::blockLastDocId() const {
+    return shallow_block_ < list_.num_blocks ? list_.blocks[shallow_block_].last_doc_id : kEnd;
+}
+
+uint32_t PostingCursor::blockMaxTermFrequency() const {
+    return shallow_block_ < list_.num_blocks ? list_.blocks[shallow_block_].max_term_frequency : 0;
+}
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include "PostingList.hpp"
+#include "StreamVByte.hpp"
+#include <algorithm>
+
+size_t PostingList::View::decodeDocIds(size_t b, uint32_t* doc_ids) const {
+    size_t count = blockSize(b);
+    if (b + 1 == num_blocks && tail_size > 0) {
+        for (size_t i = 0; i < count; ++i) doc_ids[i] = tail[i].doc_id;
+        return count;
+    }
+
+    // Gaps of the first block start from zero, later ones from the last
+    // document of the previous block
+    uint32_t previous = b > 0 ? blocks[b - 1].last_doc_id : 0;
+    StreamVByte::decodeDelta(data + blocks[b].doc_offset, count, previous, doc_ids, data_end);
+    return count;
+}
+
+size_t PostingList::View::decodeTermFrequencies(size_t b, uint32_t* term_frequencies) const {
+    size_t count = blockSize(b);
+    if (b + 1 == num_blocks && tail_size > 0) {
+        for (size_t i = 0; i < count; ++i) term_frequencies[i] = tail[i].term_frequency;
+        return count;
+    }
+
+    StreamVByte::decode(data + blocks[b].tf_offset, count, term_frequencies, data_end);
+    return count;
+}
+
+void PostingList::append(const Posting& posting) {
+    if (tail_.empty()) {
+        blocks_.push_back({posting.doc_id, 0, 0, 0});
+    }
+    tail_.push_back(posting);
+    ++size_;
+
+    BlockInfo& block = blocks_.back();
+    block.last_doc_id = posting.doc_id;
+    block.max_term_frequency = std::max(block.max_term_frequency, posting.term_frequency);
+    max_term_frequency_ = std::max(max_term_frequency_, posting.term_frequency);
+
+    if (tail_.size() == kBlockSize) {
+        sealTail();
+    }
+}
+
+void PostingList::sealTail() {
+    uint32_t doc_ids[kBlockSize];
+    uint32_t term_frequencies[kBlockSize];
+    for (size_t i = 0; i < tail_.size(); ++i) {
+        doc_ids[i] = tail_[i].doc_id;
+        term_frequencies[i] = tail_[i].term_frequency;
+    }
+
+    uint32_t previous = blocks_.size() > 1 ? blocks_[blocks_.size() - 2].last_doc_id : 0;
+    BlockInfo& block = blocks_.back();
+
+    size_t offset = data_.size();
+    data_.resize(offset + 2 * StreamVByte::maxEncodedSize(tail_.size()));
+    block.doc_offset = static_cast<uint32_t>(offset);
+    offset += StreamVByte::encodeDelta(doc_ids, tail_.size(), previous, data_.data() + offset);
+    block.tf_offset = static_cast<uint32_t>(offset);
+    offset += StreamVByte::encode(term_frequencies, tail_.size(), data_.data() + offset);
+    data_.resize(offset);
+
+    tail_.clear();
+}
+
+size_t PostingList::memoryUsage() const {
+    return data_.capacity() + blocks_.capacity() * sizeof(BlockInfo) + tail_.capacity() * sizeof(Posting);
+}
+
+PostingList::View PostingList::view() const {
+    View v;
+    v.blocks = blocks_.data();
+    v.num_blocks = blocks_.size();
+    v.data = data_.data();
+    v.data_end = data_.data() + data_.size();
+    v.tail = tail_.data();
+    v.tail_size = tail_.size();
+    v.size = size_;
+    return v;
+}
+
+std::vector<PostingList::Posting> PostingList::decode() const {
+    std::vector<Posting> postings;
+    postings.reserve(size_);
+
+    View v = view();
+    uint32_t doc_ids[kBlockSize];
+    uint32_t term_frequencies[kBlockSize];
+    for (size_t b = 0; b < v.num_blocks; ++b) {
+        size_t count = v.decodeDocIds(b, doc_ids);
+        v.decodeTermFrequencies(b, term_frequencies);
+        for (size_t i = 0; i < count; ++i) {
+            postings.push_back({doc_ids[i], term_frequencies[i]});
+        }
+    }
+    return postings;
+}
\ No newline at end of file
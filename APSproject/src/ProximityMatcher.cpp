@@ -0,0 +1,90 @@
+#include "ProximityMatcher.hpp"
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+using Positions = std::vector<uint32_t>;
+
+// Check whether some position p of the first term has term i at p + i
+bool matchPhrase(const std::vector<Positions>& positions) {
+    std::vector<size_t> next(positions.size(), 0);
+    for (uint32_t start : positions[0]) {
+        bool found = true;
+        for (size_t i = 1; i < positions.size() && found; ++i) {
+            const Positions& list = positions[i];
+            uint32_t target = start + static_cast<uint32_t>(i);
+            while (next[i] < list.size() && list[next[i]] < target) ++next[i];
+            if (next[i] == list.size()) return false;
+            found = list[next[i]] == target;
+        }
+        if (found) return true;
+    }
+    return false;
+}
+
+// Check whether two position lists hold entries at most distance apart
+bool matchNear(const Positions& a, const Positions& b, uint32_t distance) {
+    size_t i = 0;
+    size_t j = 0;
+    while (i < a.size() && j < b.size()) {
+        if (a[i] <= b[j]) {
+            if (b[j] - a[i] <= distance) return true;
+            ++i;
+        }
+        else {
+            if (a[i] - b[j] <= distance) return true;
+            ++j;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+std::vector<uint32_t> ProximityMatcher::match(std::vector<Term> terms, const Query::Proximity& constraint) {
+    std::vector<uint32_t> matches;
+    if (terms.empty()) return matches;
+
+    // Candidates come from the rarest list; the others only skip ahead
+    std::vector<size_t> order(terms.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&terms](size_t a, size_t b) {
+        return terms[a].cursor.size() < terms[b].cursor.size();
+    });
+    PostingCursor& lead = terms[order[0]].cursor;
+
+    std::vector<Positions> positions(terms.size());
+    uint32_t candidate = lead.docId();
+    while (candidate != PostingCursor::kEnd) {
+        // Move every list to the candidate; one that overshoots proposes
+        // the next candidate
+        bool aligned = true;
+        for (size_t t : order) {
+            PostingCursor& cursor = terms[t].cursor;
+            cursor.nextGEQ(candidate);
+            if (cursor.docId() != candidate) {
+                candidate = cursor.docId();
+                aligned = false;
+                break;
+            }
+        }
+        if (!aligned) continue;
+
+        for (size_t t = 0; t < terms.size(); ++t) {
+            PostingCursor& cursor = terms[t].cursor;
+            positions[t].resize(cursor.termFrequency());
+            terms[t].positions.decode(cursor.index(), positions[t].size(), positions[t].data());
+        }
+        bool matched = constraint.kind == Query::Proximity::Kind::Phrase
+                           ? matchPhrase(positions)
+                           : matchNear(positions[0], positions[1], constraint.distance);
+        if (matched) {
+            matches.push_back(candidate);
+        }
+
+        lead.next();
+        candidate = lead.docId();
+    }
+    return matches;
+}
\ No newline at end of file
@@ -0,0 +1,344 @@
+#include "Query.hpp"
+#include "Tokenizer.hpp"
+#include <algorithm>
+#include <cctype>
+
+namespace {
+
+using Node = Query::Node;
+using Proximity = Query::Proximity;
+
+constexpr std::string_view kNearOperator = "NEAR/";
+
+bool isSpace(char c) {
+    return std::isspace(static_cast<unsigned char>(c)) != 0;
+}
+
+// Recognize a NEAR/k token and read its distance
+bool parseNear(std::string_view token, uint32_t& distance) {
+    if (token.size() <= kNearOperator.size() || token.substr(0, kNearOperator.size()) != kNearOperator ||
+        token.size() - kNearOperator.size() > 9) {
+        return false;
+    }
+    distance = 0;
+    for (char c : token.substr(kNearOperator.size())) {
+        if (!std::isdigit(static_cast<unsigned char>(c))) return false;
+        distance = distance * 10 + static_cast<uint32_t>(c - '0');
+    }
+    return true;
+}
+
+struct Lexeme {
+    enum class Type { Word, Phrase, Open, Close, And, Or, Not, Near };
+
+    Type type;
+    std::vector<std::string> terms;    // One for a word, several for a phrase
+    uint32_t distance{0};              // Of a NEAR operator
+};
+
+std::vector<Lexeme> lex(std::string_view text) {
+    std::vector<Lexeme> lexemes;
+    size_t i = 0;
+    while (i < text.size()) {
+        char c = text[i];
+        if (isSpace(c)) {
+            ++i;
+        }
+        else if (c == '(' || c == ')') {
+            lexemes.push_back({c == '(' ? Lexeme::Type::Open : Lexeme::Type::Close, {}});
+            ++i;
+        }
+        else if (c == '"') {
+            // An unterminated phrase runs to the end of the query
+            size_t close = text.find('"', i + 1);
+            if (close == std::string_view::npos) close = text.size();
+            std::vector<std::string> terms = Tokenizer::tokenize(text.substr(i + 1, close - i - 1));
+            if (!terms.empty()) {
+                Lexeme::Type type = terms.size() > 1 ? Lexeme::Type::Phrase : Lexeme::Type::Word;
+                lexemes.push_back({type, std::move(terms)});
+            }
+            i = close + 1;
+        }
+        else {
+            size_t end = i;
+            while (end < text.size() && !isSpace(text[end]) && text[end] != '"' && text[end] != '(' &&
+                   text[end] != ')') {
+                ++end;
+            }
+            std::string_view token = text.substr(i, end - i);
+            uint32_t distance;
+            if (token == "AND" || token == "OR" || token == "NOT") {
+                lexemes.push_back({token == "AND" ? Lexeme::Type::And
+                                   : token == "OR" ? Lexeme::Type::Or
+                                                   : Lexeme::Type::Not, {}});
+            }
+            else if (parseNear(token, distance)) {
+                lexemes.push_back({Lexeme::Type::Near, {}, distance});
+            }
+            else {
+                std::vector<std::string> terms = Tokenizer::tokenize(token);
+                if (!terms.empty()) lexemes.push_back({Lexeme::Type::Word, std::move(terms)});
+            }
+            i = end;
+        }
+    }
+    return lexemes;
+}
+
+Node makeNode(Node::Kind kind, std::vector<Node> children) {
+    if (children.size() == 1 && kind != Node::Kind::Not) return std::move(children.front());
+    Node node{kind, {}, {}, std::move(children)};
+    return node;
+}
+
+// Whether a node only constrains positions, so juxtaposition requires it
+bool isPositional(const Node& node) {
+    if (node.kind == Node::Kind::Proximity) return true;
+    return node.kind == Node::Kind::And &&
+           std::all_of(node.children.begin(), node.children.end(), isPositional);
+}
+
+// Recursive descent over the lexemes; each level returns nothing when its
+// operands turn out empty, which drops the operators around them
+class Parser {
+public:
+    Parser(std::vector<Lexeme> lexemes, std::vector<std::string>& terms)
+        : lexemes_(std::move(lexemes)), terms_(terms) {}
+
+    // Whether parsing stopped at the nesting limit
+    bool tooDeep() const { return too_deep_; }
+
+    std::optional<Node> parse() {
+        // Stray lexemes, such as an unmatched ')', are skipped and the
+        // expressions around them juxtaposed
+        std::vector<Node> items;
+        while (pos_ < lexemes_.size()) {
+            std::optional<Node> node = parseOr();
+            if (node) {
+                items.push_back(std::move(*node));
+            }
+            else {
+                ++pos_;
+            }
+        }
+        return combineGroup(std::move(items));
+    }
+
+private:
+    std::vector<Lexeme> lexemes_;
+    std::vector<std::string>& terms_;
+    size_t pos_{0};
+    int negated_{0};
+    size_t depth_{0};
+    bool too_deep_{false};
+
+    bool peek(Lexeme::Type type) const {
+        return pos_ < lexemes_.size() && lexemes_[pos_].type == type;
+    }
+
+    static std::optional<Node> combine(Node::Kind kind, std::optional<Node> left, std::optional<Node> right) {
+        if (!left) return right;
+        if (!right) return left;
+        std::vector<Node> children;
+        for (Node* side : {&*left, &*right}) {
+            if (side->kind == kind) {
+                for (auto& child : side->children) children.push_back(std::move(child));
+            }
+            else {
+                children.push_back(std::move(*side));
+            }
+        }
+        return makeNode(kind, std::move(children));
+    }
+
+    std::optional<Node> parseOr() {
+        std::optional<Node> left = parseAnd();
+        while (peek(Lexeme::Type::Or)) {
+            ++pos_;
+            left = combine(Node::Kind::Or, std::move(left), parseAnd());
+        }
+        return left;
+    }
+
+    std::optional<Node> parseAnd() {
+        std::optional<Node> left = parseGroup();
+        while (peek(Lexeme::Type::And)) {
+            ++pos_;
+            left = combine(Node::Kind::And, std::move(left), parseGroup());
+        }
+        return left;
+    }
+
+    std::optional<Node> parseGroup() {
+        std::vector<Node> items;
+        while (peek(Lexeme::Type::Word) || peek(Lexeme::Type::Phrase) || peek(Lexeme::Type::Not) ||
+               peek(Lexeme::Type::Open)) {
+            std::optional<Node> node = parseUnary();
+            if (node) items.push_back(std::move(*node));
+        }
+        return combineGroup(std::move(items));
+    }
+
+    // Juxtaposed operands: required positional constraints if there are
+    // any, otherwise any operand, less the negated ones
+    static std::optional<Node> combineGroup(std::vector<Node> items) {
+        if (items.empty()) return std::nullopt;
+        if (items.size() == 1) return std::move(items.front());
+
+        std::vector<Node> required, optional, excluded;
+        for (auto& item : items) {
+            auto& target = item.kind == Node::Kind::Not ? excluded : isPositional(item) ? required : optional;
+            target.push_back(std::move(item));
+        }
+
+        std::vector<Node> children;
+        if (!required.empty()) {
+            children.push_back(makeNode(Node::Kind::And, std::move(required)));
+        }
+        else if (!optional.empty()) {
+            children.push_back(makeNode(Node::Kind::Or, std::move(optional)));
+        }
+        for (auto& item : excluded) children.push_back(std::move(item));
+        return makeNode(Node::Kind::And, std::move(children));
+    }
+
+    std::optional<Node> parseUnary() {
+        if ((peek(Lexeme::Type::Not) || peek(Lexeme::Type::Open)) && depth_ == Query::kMaxDepth) {
+            // Give up on the rest rather than recurse without bound
+            too_deep_ = true;
+            pos_ = lexemes_.size();
+            return std::nullopt;
+        }
+        if (peek(Lexeme::Type::Not)) {
+            ++pos_;
+            ++negated_;
+            ++depth_;
+            std::optional<Node> operand = parseUnary();
+            --depth_;
+            --negated_;
+            if (!operand) return std::nullopt;
+            std::vector<Node> children;
+            children.push_back(std::move(*operand));
+            return makeNode(Node::Kind::Not, std::move(children));
+        }
+        if (peek(Lexeme::Type::Open)) {
+            ++pos_;
+            ++depth_;
+            std::optional<Node> inner = parseOr();
+            --depth_;
+            if (peek(Lexeme::Type::Close)) ++pos_;
+            return inner;
+        }
+        if (peek(Lexeme::Type::Word) || peek(Lexeme::Type::Phrase)) {
+            return parseProximity();
+        }
+        return std::nullopt;
+    }
+
+    // A word or phrase, possibly followed by a chain of NEAR operands
+    Node parseProximity() {
+        const Lexeme* operand = &lexemes_[pos_++];
+        addTerms(operand->terms);
+
+        std::vector<Node> constraints;
+        auto addPhrase = [&constraints](const Lexeme& lexeme) {
+            if (lexeme.type == Lexeme::Type::Phrase) {
+                constraints.push_back({Node::Kind::Proximity, {}, {Proximity::Kind::Phrase, lexeme.terms, 0}, {}});
+            }
+        };
+        addPhrase(*operand);
+
+        while (peek(Lexeme::Type::Near) && pos_ + 1 < lexemes_.size() &&
+               (lexemes_[pos_ + 1].type == Lexeme::Type::Word || lexemes_[pos_ + 1].type == Lexeme::Type::Phrase)) {
+            uint32_t distance = lexemes_[pos_].distance;
+            const Lexeme* next = &lexemes_[pos_ + 1];
+            pos_ += 2;
+            addTerms(next->terms);
+            constraints.push_back({Node::Kind::Proximity, {},
+                                   {Proximity::Kind::Near, {operand->terms.back(), next->terms.front()}, distance}, {}});
+            addPhrase(*next);
+            operand = next;
+        }
+
+        if (constraints.empty()) {
+            return {Node::Kind::Term, operand->terms.front(), {}, {}};
+        }
+        return makeNode(Node::Kind::And, std::move(constraints));
+    }
+
+    void addTerms(const std::vector<std::string>& terms) {
+        if (negated_ == 0) {
+            terms_.insert(terms_.end(), terms.begin(), terms.end());
+        }
+    }
+};
+
+void appendNode(const Node& node, std::string& text) {
+    switch (node.kind) {
+        case Node::Kind::Term:
+            text += node.term;
+            break;
+        case Node::Kind::Proximity: {
+            const Proximity& proximity = node.proximity;
+            if (proximity.kind == Proximity::Kind::Phrase) {
+                text += '"';
+                for (size_t i = 0; i < proximity.terms.size(); ++i) {
+                    if (i > 0) text += ' ';
+                    text += proximity.terms[i];
+                }
+                text += '"';
+            }
+            else {
+                text += proximity.terms[0] + " NEAR/" + std::to_string(proximity.distance) + " " + proximity.terms[1];
+            }
+            break;
+        }
+        case Node::Kind::And:
+        case Node::Kind::Or:
+            text += '(';
+            for (size_t i = 0; i < node.children.size(); ++i) {
+                if (i > 0) text += node.kind == Node::Kind::And ? " AND " : " OR ";
+                appendNode(node.children[i], text);
+            }
+            text += ')';
+            break;
+        case Node::Kind::Not:
+            text += "NOT ";
+            appendNode(node.children.front(), text);
+            break;
+    }
+}
+
+} // namespace
+
+Query Query::parse(std::string_view text) {
+    Query query;
+    Parser parser(lex(text), query.terms);
+    query.filter = parser.parse();
+    if (parser.tooDeep()) return Query();
+
+    // A plain list of terms matches any of them, which ranked retrieval
+    // does without a filter
+    if (query.filter) {
+        const Node& root = *query.filter;
+        bool plain = root.kind == Node::Kind::Term ||
+                     (root.kind == Node::Kind::Or &&
+                      std::all_of(root.children.begin(), root.children.end(),
+                                  [](const Node& child) { return child.kind == Node::Kind::Term; }));
+        if (plain) query.filter.reset();
+    }
+    return query;
+}
+
+std::string Query::normalized() const {
+    std::string text;
+    for (const auto& term : terms) {
+        text += term;
+        text += ' ';
+    }
+    if (filter) {
+        text += "| ";
+        appendNode(*filter, text);
+    }
+    return text;
+}
\ No newline at end of file
@@ -0,0 +1,216 @@
+#include "QueryEvaluator.hpp"
+#include "Intersection.hpp"
+#include "PostingCursor.hpp"
+#include "ProximityMatcher.hpp"
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+using Node = Query::Node;
+using TermPostings = IndexSnapshot::TermPostings;
+
+std::vector<uint32_t> difference(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+    std::vector<uint32_t> result;
+    result.reserve(a.size());
+    std::set_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result));
+    return result;
+}
+
+} // namespace
+
+std::vector<uint32_t> QueryEvaluator::evaluate(const Node& node) const {
+    switch (node.kind) {
+        case Node::Kind::Term: {
+            std::vector<TermPostings> postings;
+            snapshot_.lookupTerm(node.term, postings);
+            return termDocuments(postings);
+        }
+        case Node::Kind::Proximity:
+            return proximityDocuments(node.proximity);
+        case Node::Kind::And:
+            return evaluateAnd(node);
+        case Node::Kind::Or:
+            return evaluateOr(node);
+        case Node::Kind::Not:
+            return complement(evaluate(node.children.front()));
+    }
+    return {};
+}
+
+std::vector<uint32_t> QueryEvaluator::evaluateAnd(const Node& node) const {
+    // Terms stay compressed until they are intersected; other operands are
+    // evaluated up front, as their size is only known then
+    struct Operand {
+        size_t size{0};
+        bool is_term{false};
+        std::vector<TermPostings> postings;
+        std::vector<uint32_t> documents;
+    };
+    std::vector<Operand> operands;
+    std::vector<const Node*> excluded;
+    for (const auto& child : node.children) {
+        if (child.kind == Node::Kind::Not) {
+            excluded.push_back(&child.children.front());
+            continue;
+        }
+        Operand operand;
+        if (child.kind == Node::Kind::Term) {
+            operand.is_term = true;
+            snapshot_.lookupTerm(child.term, operand.postings);
+            for (const auto& part : operand.postings) operand.size += part.postings.size;
+        }
+        else {
+            operand.documents = evaluate(child);
+            operand.size = operand.documents.size();
+        }
+        if (operand.size == 0) return {};
+        operands.push_back(std::move(operand));
+    }
+
+    // Start from the rarest operand, so every step probes the fewest
+    // candidates
+    std::sort(operands.begin(), operands.end(),
+              [](const Operand& a, const Operand& b) { return a.size < b.size; });
+    std::vector<uint32_t> candidates;
+    if (operands.empty()) {
+        candidates = complement({});
+    }
+    else if (operands.front().is_term) {
+        candidates = termDocuments(operands.front().postings);
+    }
+    else {
+        candidates = std::move(operands.front().documents);
+    }
+
+    std::vector<uint32_t> narrowed;
+    for (size_t i = 1; i < operands.size() && !candidates.empty(); ++i) {
+        if (operands[i].is_term) {
+            candidates = intersectPostings(candidates, operands[i].postings);
+        }
+        else {
+            const auto& documents = operands[i].documents;
+            narrowed.resize(std::min(candidates.size(), documents.size()));
+            narrowed.resize(Intersection::intersect(candidates.data(), candidates.size(), documents.data(),
+                                                    documents.size(), narrowed.data()));
+            candidates.swap(narrowed);
+        }
+    }
+
+    for (const Node* operand : excluded) {
+        if (candidates.empty()) break;
+        candidates = difference(candidates, evaluate(*operand));
+    }
+    return candidates;
+}
+
+std::vector<uint32_t> QueryEvaluator::evaluateOr(const Node& node) const {
+    std::vector<uint32_t> result;
+    std::vector<uint32_t> merged;
+    for (const auto& child : node.children) {
+        std::vector<uint32_t> documents = evaluate(child);
+        merged.clear();
+        merged.reserve(result.size() + documents.size());
+        std::set_union(result.begin(), result.end(), documents.begin(), documents.end(), std::back_inserter(merged));
+        result.swap(merged);
+    }
+    return result;
+}
+
+std::vector<uint32_t> QueryEvaluator::termDocuments(const std::vector<TermPostings>& postings) const {
+    // Parts are listed in order and their bases grow, so the result is sorted
+    std::vector<uint32_t> documents;
+    uint32_t doc_ids[PostingList::kBlockSize];
+    for (const auto& part : postings) {
+        for (size_t b = 0; b < part.postings.num_blocks; ++b) {
+            size_t count = part.postings.decodeDocIds(b, doc_ids);
+            for (size_t i = 0; i < count; ++i) documents.push_back(part.base + doc_ids[i]);
+        }
+    }
+    return documents;
+}
+
+std::vector<uint32_t> QueryEvaluator::proximityDocuments(const Query::Proximity& proximity) const {
+    std::vector<std::vector<TermPostings>> postings(proximity.terms.size());
+    for (size_t t = 0; t < proximity.terms.size(); ++t) {
+        snapshot_.lookupTerm(proximity.terms[t], postings[t]);
+    }
+
+    // A document lives in one part, so parts are matched independently
+    std::vector<uint32_t> documents;
+    for (size_t part = 0; part < snapshot_.getPartCount(); ++part) {
+        std::vector<ProximityMatcher::Term> terms;
+        uint32_t base = 0;
+        for (const auto& term_postings : postings) {
+            auto it = std::find_if(term_postings.begin(), term_postings.end(),
+                                   [part](const TermPostings& p) { return p.part == part; });
+            if (it == term_postings.end() || !it->positions.available()) break;
+            base = it->base;
+            terms.push_back({PostingCursor(it->postings), it->positions});
+        }
+        if (terms.size() != proximity.terms.size()) continue;
+
+        for (uint32_t doc_id : ProximityMatcher::match(std::move(terms), proximity)) {
+            documents.push_back(base + doc_id);
+        }
+    }
+    return documents;
+}
+
+std::vector<uint32_t> QueryEvaluator::complement(const std::vector<uint32_t>& documents) const {
+    std::vector<uint32_t> result;
+    result.reserve(snapshot_.getTotalDocuments() - documents.size());
+    auto it = documents.begin();
+    for (uint32_t doc_id = 0; doc_id < snapshot_.getTotalDocuments(); ++doc_id) {
+        if (it != documents.end() && *it == doc_id) {
+            ++it;
+        }
+        else {
+            result.push_back(doc_id);
+        }
+    }
+    return result;
+}
+
+std::vector<uint32_t> QueryEvaluator::intersectPostings(const std::vector<uint32_t>& candidates,
+                                                        const std::vector<TermPostings>& postings) const {
+    std::vector<uint32_t> result;
+    result.reserve(candidates.size());
+    uint32_t doc_ids[PostingList::kBlockSize];
+    auto first = candidates.begin();
+    for (const auto& part : postings) {
+        // The candidates of this part, as local IDs relative to its base
+        first = std::lower_bound(first, candidates.end(), part.base);
+        auto last = std::lower_bound(first, candidates.end(), snapshot_.getPartBase(part.part + 1));
+        const PostingList::View& list = part.postings;
+        size_t count = static_cast<size_t>(last - first);
+
+        if (list.size > count * Intersection::kGallopRatio) {
+            // Sparse candidates: skip blocks without decoding them
+            PostingCursor cursor(list);
+            for (auto it = first; it != last; ++it) {
+                cursor.nextGEQ(*it - part.base);
+                if (cursor.docId() == PostingCursor::kEnd) break;
+                if (cursor.docId() == *it - part.base) result.push_back(*it);
+            }
+        }
+        else {
+            // Dense candidates: intersect them with every block they reach
+            auto block_first = first;
+            for (size_t b = 0; b < list.num_blocks && block_first != last; ++b) {
+                auto block_last = std::upper_bound(block_first, last, part.base + list.blocks[b].last_doc_id);
+                if (block_last == block_first) continue;
+
+                size_t size = list.decodeDocIds(b, doc_ids);
+                for (size_t i = 0; i < size; ++i) doc_ids[i] += part.base;
+                size_t offset = result.size();
+                result.resize(offset + std::min<size_t>(size, block_last - block_first));
+                result.resize(offset + Intersection::intersect(&*block_first, block_last - block_first, doc_ids,
+                                                               size, result.data() + offset));
+                block_first = block_last;
+            }
+        }
+        first = last;
+    }
+    return result;
+}
\ No newline at end of file
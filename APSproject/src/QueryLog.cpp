@@ -0,0 +1,103 @@
+#include "QueryLog.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+QueryLog::QueryLog(Publisher publisher, std::chrono::milliseconds interval, std::chrono::milliseconds half_life,
+                   size_t max_terms)
+    : publisher_(std::move(publisher)),
+      interval_(interval),
+      decay_rate_(std::log(2.0) / std::chrono::duration<double>(half_life).count()),
+      max_terms_(max_terms),
+      last_aggregation_(std::chrono::steady_clock::now()),
+      worker_(&QueryLog::workerLoop, this) {}
+
+QueryLog::~QueryLog() {
+    {
+        std::lock_guard<std::mutex> lock(worker_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    worker_.join();
+}
+
+void QueryLog::record(const std::vector<std::string>& terms) {
+    if (terms.empty()) return;
+    
+    // Threads keep to their own shard, so they rarely meet on its mutex
+    Shard& shard = shards_[std::hash<std::thread::id>()(std::this_thread::get_id()) % kShards];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    for (const auto& term : terms) {
+        ++shard.counts[term];
+    }
+}
+
+void QueryLog::flush() {
+    aggregate();
+}
+
+void QueryLog::republish() {
+    std::lock_guard<std::mutex> lock(aggregate_mutex_);
+    for (auto& [term, score] : scores_) {
+        score.published = 0;
+    }
+}
+
+void QueryLog::aggregate() {
+    std::lock_guard<std::mutex> lock(aggregate_mutex_);
+    
+    // Decay old scores by the time since the last aggregation, then add the
+    // new counts at full weight
+    auto now = std::chrono::steady_clock::now();
+    double factor = std::exp(-decay_rate_ * std::chrono::duration<double>(now - last_aggregation_).count());
+    last_aggregation_ = now;
+    for (auto& [term, score] : scores_) {
+        score.value *= factor;
+    }
+    
+    for (Shard& shard : shards_) {
+        std::unordered_map<std::string, size_t> counts;
+        {
+            std::lock_guard<std::mutex> shard_lock(shard.mutex);
+            counts.swap(shard.counts);
+        }
+        for (auto& [term, count] : counts) {
+            scores_.try_emplace(term, Score{0.0, 0}).first->second.value += static_cast<double>(count);
+        }
+    }
+    
+    // Beyond max_terms, zero the lowest scores so that they are dropped below
+    if (scores_.size() > max_terms_) {
+        std::vector<Score*> ranked;
+        ranked.reserve(scores_.size());
+        for (auto& [term, score] : scores_) ranked.push_back(&score);
+        std::nth_element(ranked.begin(), ranked.begin() + (scores_.size() - max_terms_), ranked.end(),
+                         [](const Score* a, const Score* b) { return a->value < b->value; });
+        for (size_t i = 0; i < scores_.size() - max_terms_; ++i) {
+            ranked[i]->value = 0.0;
+        }
+    }
+    
+    std::vector<std::pair<std::string, size_t>> changes;
+    for (auto it = scores_.begin(); it != scores_.end();) {
+        size_t popularity = static_cast<size_t>(std::llround(it->second.value));
+        if (popularity != it->second.published) {
+            changes.emplace_back(it->first, popularity);
+            it->second.published = popularity;
+        }
+        it = popularity == 0 ? scores_.erase(it) : std::next(it);
+    }
+    
+    if (!changes.empty()) {
+        publisher_(changes);
+    }
+}
+
+void QueryLog::workerLoop() {
+    std::unique_lock<std::mutex> lock(worker_mutex_);
+    while (!wake_.wait_for(lock, interval_, [this]() { return stopping_; })) {
+        lock.unlock();
+        aggregate();
+        lock.lock();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,187 @@
+#include "RansCompression.hpp"
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <stdexcept>
+
+namespace {
+
+constexpr uint32_t kTotal = 1u << RansCompression::kScaleBits;
+
+// States stay in [kLowerBound, kLowerBound << 16) between symbols and are
+// renormalized 16 bits at a time, so each step moves at most one word
+constexpr uint32_t kLowerBound = 1u << 16;
+
+constexpr size_t kSizeBytes = 8;
+constexpr size_t kBitmapBytes = 32;
+
+[[noreturn]] void corrupt() {
+    throw std::runtime_error("Corrupt rANS data");
+}
+
+// Scale byte counts to frequencies summing to kTotal, keeping every byte
+// that occurs at a frequency of at least one
+std::array<uint32_t, 256> normalize(const std::array<size_t, 256>& counts, size_t total) {
+    std::array<uint32_t, 256> frequencies{};
+    uint32_t sum = 0;
+    for (int c = 0; c < 256; ++c) {
+        if (counts[c] == 0) continue;
+        frequencies[c] = std::max<uint32_t>(1, static_cast<uint32_t>(static_cast<double>(counts[c]) * kTotal / total));
+        sum += frequencies[c];
+    }
+
+    // Settle the rounding error on the most frequent bytes, where a step
+    // changes the probability least. At most 256 bytes were rounded up, so
+    // this takes few steps.
+    while (sum > kTotal) {
+        --*std::max_element(frequencies.begin(), frequencies.end());
+        --sum;
+    }
+    *std::max_element(frequencies.begin(), frequencies.end()) += kTotal - sum;
+    return frequencies;
+}
+
+uint32_t loadLE32(const unsigned char* p) {
+    return uint32_t{p[0]} | uint32_t{p[1]} << 8 | uint32_t{p[2]} << 16 | uint32_t{p[3]} << 24;
+}
+
+void storeLE32(unsigned char* p, uint32_t value) {
+    for (int i = 0; i < 4; ++i) p[i] = static_cast<unsigned char>(value >> (8 * i));
+}
+
+} // namespace
+
+std::vector<unsigned char> RansCompression::compress(const char* data, size_t size) const {
+    if (size == 0) return {};
+
+    std::array<size_t, 256> counts{};
+    for (size_t i = 0; i < size; ++i) {
+        counts[static_cast<unsigned char>(data[i])]++;
+    }
+    std::array<uint32_t, 256> frequencies = normalize(counts, size);
+    std::array<uint32_t, 256> starts{};
+    size_t symbol_count = 0;
+    for (int c = 0, start = 0; c < 256; ++c) {
+        starts[c] = start;
+        start += frequencies[c];
+        symbol_count += frequencies[c] > 0;
+    }
+
+    size_t header_size = kSizeBytes + kBitmapBytes + 2 * symbol_count;
+    std::vector<unsigned char> header(header_size);
+    for (size_t i = 0; i < kSizeBytes; ++i) {
+        header[i] = static_cast<unsigned char>(uint64_t{size} >> (8 * i));
+    }
+    for (int c = 0, slot = 0; c < 256; ++c) {
+        if (frequencies[c] == 0) continue;
+        header[kSizeBytes + c / 8] |= static_cast<unsigned char>(1 << (c % 8));
+        header[kSizeBytes + kBitmapBytes + 2 * slot] = static_cast<unsigned char>(frequencies[c]);
+        header[kSizeBytes + kBitmapBytes + 2 * slot + 1] = static_cast<unsigned char>(frequencies[c] >> 8);
+        ++slot;
+    }
+
+    // rANS decodes in reverse order of encoding, so encode backwards into
+    // the end of a buffer. A symbol emits at most one 16-bit word.
+    std::vector<unsigned char> buffer(size * 2 + 8);
+    unsigned char* end = buffer.data() + buffer.size();
+    unsigned char* out = end;
+    uint32_t states[2] = {kLowerBound, kLowerBound};
+    for (size_t i = size; i-- > 0;) {
+        unsigned char symbol = static_cast<unsigned char>(data[i]);
+        uint32_t frequency = frequencies[symbol];
+        uint32_t& state = states[i & 1];
+
+        // 64-bit: a byte owning every slot has a limit of 2^32, which no
+        // state reaches, so it never emits anything
+        uint64_t limit = uint64_t{(kLowerBound >> kScaleBits) << 16} * frequency;
+        if (state >= limit) {
+            out -= 2;
+            out[0] = static_cast<unsigned char>(state);
+            out[1] = static_cast<unsigned char>(state >> 8);
+            state >>= 16;
+        }
+        state = ((state / frequency) << kScaleBits) + (state % frequency) + starts[symbol];
+    }
+    out -= 4;
+    storeLE32(out, states[1]);
+    out -= 4;
+    storeLE32(out, states[0]);
+
+    header.insert(header.end(), out, end);
+    return header;
+}
+
+uint64_t RansCompression::maxDecodedSize(const unsigned char* data, size_t size) const {
+    if (size < kSizeBytes + kBitmapBytes) return 0;
+    
+    uint64_t original_size = 0;
+    for (size_t i = 0; i < kSizeBytes; ++i) {
+        original_size |= uint64_t{data[i]} << (8 * i);
+    }
+    size_t symbol_count = 0;
+    for (size_t i = 0; i < kBitmapBytes; ++i) {
+        symbol_count += std::bitset<8>(data[kSizeBytes + i]).count();
+    }
+    if (symbol_count == 0 || size < kSizeBytes + kBitmapBytes + 2 * symbol_count + 8) return 0;
+    return original_size;
+}
+
+void RansCompression::decompress(const unsigned char* data, size_t size, char* out, size_t out_size) const {
+    if (size == 0 && out_size == 0) return;
+    if (size < kSizeBytes + kBitmapBytes) corrupt();
+
+    uint64_t original_size = 0;
+    for (size_t i = 0; i < kSizeBytes; ++i) {
+        original_size |= uint64_t{data[i]} << (8 * i);
+    }
+    if (original_size != out_size) corrupt();
+
+    size_t symbol_count = 0;
+    for (size_t i = 0; i < kBitmapBytes; ++i) {
+        symbol_count += std::bitset<8>(data[kSizeBytes + i]).count();
+    }
+    size_t header_size = kSizeBytes + kBitmapBytes + 2 * symbol_count;
+    if (symbol_count == 0 || size < header_size + 8) corrupt();
+
+    // Slot table: the byte owning each of the kTotal probability slots,
+    // with what a decoding step needs, so each step is one lookup
+    struct Slot {
+        uint16_t frequency;
+        uint16_t offset;    // Position within the byte's slot range
+        uint8_t symbol;
+    };
+    std::vector<Slot> slots(kTotal);
+    uint32_t start = 0;
+    for (int c = 0, slot = 0; c < 256; ++c) {
+        if (!(data[kSizeBytes + c / 8] & (1 << (c % 8)))) continue;
+        const unsigned char* stored = data + kSizeBytes + kBitmapBytes + 2 * slot++;
+        uint32_t frequency = uint32_t{stored[0]} | uint32_t{stored[1]} << 8;
+        if (frequency == 0 || frequency > kTotal - start) corrupt();
+        for (uint32_t i = 0; i < frequency; ++i) {
+            slots[start + i] = {static_cast<uint16_t>(frequency), static_cast<uint16_t>(i), static_cast<uint8_t>(c)};
+        }
+        start += frequency;
+    }
+    if (start != kTotal) corrupt();
+
+    const unsigned char* in = data + header_size;
+    const unsigned char* end = data + size;
+    uint32_t states[2] = {loadLE32(in), loadLE32(in + 4)};
+    in += 8;
+
+    const uint32_t mask = kTotal - 1;
+    for (size_t i = 0; i < out_size; ++i) {
+        uint32_t& state = states[i & 1];
+        const Slot& slot = slots[state & mask];
+        out[i] = static_cast<char>(slot.symbol);
+        state = slot.frequency * (state >> kScaleBits) + slot.offset;
+        if (state < kLowerBound) {
+            if (end - in < 2) corrupt();
+            state = state << 16 | uint32_t{in[0]} | uint32_t{in[1]} << 8;
+            in += 2;
+        }
+    }
+
+    // The encoder started both states at the lower bound
+    if (states[0] != kLowerBound || states[1] != kLowerBound || in != end) corrupt();
+}
\ No newline at end of file
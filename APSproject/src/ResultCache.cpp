@@ -0,0 +1,81 @@
+#include "ResultCache.hpp"
+#include <functional>
+
+ResultCache::ResultCache(size_t capacity) : capacity_(capacity) {}
+
+ResultCache::Shard& ResultCache::shardFor(const std::string& key) {
+    return shards_[std::hash<std::string>()(key) % kShards];
+}
+
+std::shared_ptr<const ResultCache::Results> ResultCache::lookup(const std::string& key, uint64_t generation) {
+    Shard& shard = shardFor(key);
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            auto entry = it->second;
+            if (entry->generation == generation) {
+                shard.entries.splice(shard.entries.begin(), shard.entries, entry);
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                return entry->results;
+            }
+
+            // Entries of older generations can never hit again
+            if (entry->generation < generation) {
+                shard.index.erase(it);
+                shard.entries.erase(entry);
+            }
+        }
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+}
+
+void ResultCache::insert(const std::string& key, uint64_t generation, Results results) {
+    size_t limit = shardCapacity();
+    if (limit == 0) return;
+
+    auto shared = std::make_shared<const Results>(std::move(results));
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        // A query on an older snapshot must not replace newer results
+        auto entry = it->second;
+        if (entry->generation <= generation) {
+            entry->generation = generation;
+            entry->results = std::move(shared);
+        }
+        shard.entries.splice(shard.entries.begin(), shard.entries, entry);
+        return;
+    }
+
+    shard.entries.push_front({key, generation, std::move(shared)});
+    shard.index.emplace(shard.entries.front().key, shard.entries.begin());
+    evict(shard, limit);
+}
+
+void ResultCache::setCapacity(size_t capacity) {
+    capacity_.store(capacity, std::memory_order_relaxed);
+    size_t limit = shardCapacity();
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        evict(shard, limit);
+    }
+}
+
+ResultCache::Stats ResultCache::getStats() const {
+    Stats stats{hits_.load(std::memory_order_relaxed), misses_.load(std::memory_order_relaxed), 0};
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        stats.entries += shard.entries.size();
+    }
+    return stats;
+}
+
+void ResultCache::evict(Shard& shard, size_t limit) {
+    while (shard.entries.size() > limit) {
+        shard.index.erase(shard.entries.back().key);
+        shard.entries.pop_back();
+    }
+}
\ No newline at end of file
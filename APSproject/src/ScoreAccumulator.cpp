@@ -0,0 +1,16 @@
+#include "ScoreAccumulator.hpp"
+#include <algorithm>
+
+void ScoreAccumulator::reset(size_t num_documents) {
+    if (scores_.size() < num_documents) {
+        scores_.resize(num_documents, 0.0);
+        stamps_.resize(num_documents, 0);
+    }
+    touched_.clear();
+
+    // On wrap-around, old stamps could alias the new generation
+    if (++generation_ == 0) {
+        std::fill(stamps_.begin(), stamps_.end(), 0);
+        generation_ = 1;
+    }
+}
\ No newline at end of file
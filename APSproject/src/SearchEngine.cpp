@@ -1,26 +1,105 @@
 #include "SearchEngine.hpp"
+#include "MappedFile.hpp"
+#include "CompressedFile.hpp"
+#include "QueryEvaluator.hpp"
 #include <algorithm>
-#include <sstream>
-#include <unordered_map>
-#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+// Index file header: magic bytes, format version and a table of segment
+// (offset, size) pairs, followed by the autocomplete and spelling sections
+// and the segments themselves
+constexpr char kIndexMagic[8] = {'A', 'P', 'S', 'I', 'N', 'D', 'E', 'X'};
+constexpr uint32_t kIndexFormatVersion = 3;
+
+// Documents buffered in memory before they are frozen into a segment
+constexpr size_t kDefaultFlushThreshold = 4096;
+
+// Documents the write buffer's index holds before they are frozen into a
+// buffer chunk; publishing copies at most this many
+constexpr size_t kBufferChunkSize = 64;
+
+// Result lists kept for repeated queries
+constexpr size_t kDefaultResultCacheCapacity = 1024;
+
+// Query popularity is aggregated every second, halves every hour and is
+// tracked for the most popular terms only
+constexpr std::chrono::milliseconds kQueryLogInterval{1000};
+constexpr std::chrono::milliseconds kPopularityHalfLife{3600 * 1000};
+constexpr size_t kMaxPopularTerms = 100000;
+
+// Tiered merging: segments are grouped into tiers whose size limits grow by
+// this factor, and this many adjacent segments of one tier are merged into
+// one of the next. A document is rewritten once per tier it climbs, so
+// write amplification is logarithmic in the index size.
+constexpr size_t kMergeFactor = 4;
+
+size_t mergeTier(size_t documents, size_t flush_threshold) {
+    size_t tier = 0;
+    for (size_t limit = flush_threshold; documents > limit; limit *= kMergeFactor) {
+        ++tier;
+    }
+    return tier;
+}
 
-SearchEngine::SearchEngine() 
-    : tfidf_calculator_(std::make_unique<TFIDFCalculator>(index_)),
-      compressor_(std::make_unique<HuffmanCompression>()),
+} // namespace
+
+SearchEngine::SearchEngine(size_t num_threads) 
+    : snapshot_(new IndexSnapshot(segments_, buffer_chunks_, index_, 0)),
+      flush_threshold_(kDefaultFlushThreshold),
+      merge_pool_(std::make_unique<ThreadPool>(1)),
       autocomplete_trie_(std::make_unique<Trie>()),
-      spell_corrector_(std::make_unique<SpellCorrector>()) {}
+      spell_corrector_(std::make_unique<SpellCorrector>()),
+      query_log_([this](const auto& changes) { publishPopularity(changes); }, kQueryLogInterval,
+                 kPopularityHalfLife, kMaxPopularTerms),
+      thread_pool_(std::make_unique<ThreadPool>(num_threads)),
+      result_cache_(kDefaultResultCacheCapacity) {
+    index_.setStorePositions(true);
+}
+
+SearchEngine::~SearchEngine() {
+    // A finishing merge publishes a snapshot, so let it complete first
+    waitForMerges();
+    delete snapshot_.load();
+}
 
 void SearchEngine::addDocument(const std::string& id, const std::string& path) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    indexDocument(id, path);
+    maintainWriteBuffer();
+    publishSnapshot();
+    scheduleMerge();
+}
+
+bool SearchEngine::containsDocument(const std::string& id) const {
+    // Writers hold write_mutex_, so the latest snapshot matches their state
+    // and cannot be retired while they read it
+    return snapshot_.load()->containsDocument(id);
+}
+
+void SearchEngine::indexDocument(const std::string& id, const std::string& path) {
+    if (containsDocument(id)) {
+        throw std::invalid_argument("Duplicate document id: " + id);
+    }
+    
     auto doc = std::make_shared<Document>(id, path);
-    if (doc->parse()) {
-        documents_.push_back(doc);
+    if (doc->parse(index_.hasPositions())) {
         index_.addDocument(doc);
         
         // Update autocomplete and spell correction with document words
-        const auto& frequencies = doc->getWordFrequencies();
-        for (const auto& [word, _] : frequencies) {
-            updateSearchHelpers(word);
+        std::unique_lock<std::shared_mutex> helpers_lock(helpers_mutex_);
+        for (const auto& [word, _] : doc->getWordOccurrences()) {
+            updateSearchHelpers(std::string(word));
         }
     }
     else {
@@ -28,146 +107,667 @@ void SearchEngine::addDocument(const std::string& id, const std::string& path) {
     }
 }
 
-void SearchEngine::updateSearchHelpers(const std::string& word) {
-    autocomplete_trie_->insert(word);
-    spell_corrector_->addWord(word);
-}
-
-std::vector<std::pair<std::string, double>> SearchEngine::search(const std::string& query, size_t num_results) const {
-    std::vector<std::string> query_terms = tokenizeQuery(query);
-    std::unordered_map<std::string, double> doc_scores;
+void SearchEngine::addDocuments(const std::vector<std::pair<std::string, std::string>>& documents) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
     
-    // Calculate scores for each document
-    for (const auto& doc : documents_) {
-        double score = 0.0;
-        for (const auto& term : query_terms) {
-            score += tfidf_calculator_->calculateTFIDF(term, *doc);
+    std::unordered_set<std::string> batch_ids;
+    for (const auto& [id, path] : documents) {
+        if (containsDocument(id) || !batch_ids.insert(id).second) {
+            throw std::invalid_argument("Duplicate document id: " + id);
         }
-        if (score > 0.0) {
-            doc_scores[doc->getId()] = score;
+    }
+    if (documents.empty()) return;
+    
+    // Parse contiguous chunks in parallel so partial indexes merge in order
+    size_t num_chunks = std::min(thread_pool_->size(), documents.size());
+    std::vector<std::future<InvertedIndex::PartialIndex>> chunks;
+    chunks.reserve(num_chunks);
+    for (size_t c = 0; c < num_chunks; ++c) {
+        size_t begin = documents.size() * c / num_chunks;
+        size_t end = documents.size() * (c + 1) / num_chunks;
+        chunks.push_back(thread_pool_->submit([&documents, begin, end, store_positions = index_.hasPositions()]() {
+            InvertedIndex::PartialIndex partial;
+            partial.store_positions = store_positions;
+            for (size_t i = begin; i < end; ++i) {
+                Document doc(documents[i].first, documents[i].second);
+                if (!doc.parse(store_positions)) {
+                    throw std::runtime_error("Failed to parse document: " + documents[i].second);
+                }
+                partial.addDocument(doc);
+            }
+            return partial;
+        }));
+    }
+    
+    // Tasks reference the batch, so wait for all of them before any rethrow
+    for (auto& chunk : chunks) chunk.wait();
+    std::vector<InvertedIndex::PartialIndex> partials;
+    partials.reserve(num_chunks);
+    for (auto& chunk : chunks) partials.push_back(chunk.get());
+    
+    // Merge postings and publish the batch as one snapshot, then update the
+    // helpers once per distinct word
+    std::unordered_map<std::string, size_t> new_words;
+    for (const auto& partial : partials) {
+        index_.mergePartial(partial);
+        for (const auto& [word, postings] : partial.postings) {
+            new_words[word] += postings.size();
         }
     }
+    maintainWriteBuffer();
+    publishSnapshot();
+    scheduleMerge();
     
-    // Convert to vector and sort by score
-    std::vector<std::pair<std::string, double>> results;
-    results.reserve(doc_scores.size());
-    for (const auto& [doc_id, score] : doc_scores) {
-        results.emplace_back(doc_id, score);
+    std::unique_lock<std::shared_mutex> helpers_lock(helpers_mutex_);
+    for (const auto& [word, count] : new_words) {
+        updateSearchHelpers(word, count);
+    }
+}
+
+void SearchEngine::publishSnapshot() {
+    const IndexSnapshot* previous =
+        snapshot_.exchange(new IndexSnapshot(segments_, buffer_chunks_, index_, ++generation_));
+    epochs_.retire([previous]() { delete previous; });
+    epochs_.reclaim();
+}
+
+void SearchEngine::setFlushThreshold(size_t documents) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    flush_threshold_ = std::max<size_t>(documents, 1);
+}
+
+size_t SearchEngine::getFlushThreshold() const {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    return flush_threshold_;
+}
+
+void SearchEngine::flush() {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    if (getBufferedDocuments() == 0) return;
+    flushWriteBuffer();
+    publishSnapshot();
+    scheduleMerge();
+}
+
+size_t SearchEngine::getBufferedDocuments() const {
+    size_t documents = index_.getTotalDocuments();
+    for (const auto& chunk : buffer_chunks_) {
+        documents += chunk->getTotalDocuments();
+    }
+    return documents;
+}
+
+void SearchEngine::maintainWriteBuffer() {
+    if (getBufferedDocuments() >= flush_threshold_) {
+        flushWriteBuffer();
+    }
+    else if (index_.getTotalDocuments() >= kBufferChunkSize) {
+        freezeBufferChunk();
     }
+}
+
+void SearchEngine::flushWriteBuffer() {
+    // The chunks and the index's documents become one segment
+    IndexSnapshot::SegmentList chunks;
+    chunks.swap(buffer_chunks_);
+    if (index_.getTotalDocuments() > 0) {
+        chunks.push_back(IndexSegment::fromIndex(index_));
+        resetWriteIndex();
+    }
+    if (chunks.size() == 1) {
+        segments_.push_back(std::move(chunks.front()));
+    }
+    else if (!chunks.empty()) {
+        segments_.push_back(IndexSegment::merge(chunks, index_.hasImpacts()));
+    }
+}
+
+void SearchEngine::freezeBufferChunk() {
+    buffer_chunks_.push_back(IndexSegment::fromIndex(index_));
+    resetWriteIndex();
     
-    std::sort(results.begin(), results.end(),
-              [](const auto& a, const auto& b) { return a.second > b.second; });
+    // Merge the newest chunks while the older one is no larger, as in a
+    // binary counter: sizes halve towards the newest chunk, so there are
+    // O(log n) of them and each document is rewritten O(log n) times
+    while (buffer_chunks_.size() >= 2 &&
+           buffer_chunks_[buffer_chunks_.size() - 2]->getTotalDocuments() <=
+               buffer_chunks_.back()->getTotalDocuments()) {
+        IndexSnapshot::SegmentList pair(buffer_chunks_.end() - 2, buffer_chunks_.end());
+        buffer_chunks_.pop_back();
+        buffer_chunks_.back() = IndexSegment::merge(pair, index_.hasImpacts());
+    }
+}
+
+void SearchEngine::resetWriteIndex() {
+    InvertedIndex buffer;
+    buffer.setStoreImpacts(index_.hasImpacts());
+    buffer.setStorePositions(index_.hasPositions());
+    index_ = std::move(buffer);
+}
+
+void SearchEngine::scheduleMerge() {
+    if (merging_) return;
     
-    // Return top N results
-    if (results.size() > num_results) {
-        results.resize(num_results);
+    // Find the oldest run of kMergeFactor adjacent segments in one tier.
+    // Merging adjacent segments keeps documents in insertion order.
+    size_t run_start = 0;
+    size_t run_tier = 0;
+    size_t first = segments_.size();
+    for (size_t i = 0; i < segments_.size(); ++i) {
+        size_t tier = mergeTier(segments_[i]->getTotalDocuments(), flush_threshold_);
+        if (i == run_start || tier != run_tier) {
+            run_start = i;
+            run_tier = tier;
+        }
+        if (i + 1 - run_start == kMergeFactor) {
+            first = run_start;
+            break;
+        }
     }
+    if (first == segments_.size()) return;
     
-    // Update word frequencies in trie for better suggestions
-    for (const auto& term : query_terms) {
-        autocomplete_trie_->incrementFrequency(term);
+    IndexSnapshot::SegmentList inputs(segments_.begin() + first, segments_.begin() + first + kMergeFactor);
+    bool store_impacts = index_.hasImpacts();
+    merging_ = true;
+    merge_pool_->submit([this, inputs = std::move(inputs), store_impacts]() {
+        // Segments are immutable, so they are merged without any lock
+        std::shared_ptr<const IndexSegment> merged;
+        try {
+            merged = IndexSegment::merge(inputs, store_impacts);
+        }
+        catch (const std::exception&) {
+            // Keep the inputs; the next write tries again
+        }
+        
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        merging_ = false;
+        
+        // A load may have replaced the segments in the meantime
+        auto it = std::search(segments_.begin(), segments_.end(), inputs.begin(), inputs.end());
+        if (merged && it != segments_.end()) {
+            it = segments_.erase(it, it + inputs.size());
+            segments_.insert(it, std::move(merged));
+            publishSnapshot();
+            scheduleMerge();
+        }
+        merge_finished_.notify_all();
+    });
+}
+
+void SearchEngine::waitForMerges() {
+    std::unique_lock<std::mutex> lock(write_mutex_);
+    merge_finished_.wait(lock, [this]() { return !merging_; });
+}
+
+size_t SearchEngine::getSegmentCount() const {
+    EpochManager::Guard guard(epochs_);
+    const IndexSnapshot& snapshot = *snapshot_.load();
+    return snapshot.getSegments().size() - snapshot.getBufferChunkCount();
+}
+
+void SearchEngine::updateSearchHelpers(const std::string& word, size_t count) {
+    autocomplete_trie_->insert(word, count);
+    spell_corrector_->addWord(word, count);
+}
+
+void SearchEngine::publishPopularity(const std::vector<std::pair<std::string, size_t>>& changes) {
+    std::unique_lock<std::shared_mutex> lock(helpers_mutex_);
+    for (const auto& [term, popularity] : changes) {
+        autocomplete_trie_->setPopularity(term, popularity);
+    }
+}
+
+void SearchEngine::flushQueryLog() {
+    query_log_.flush();
+}
+
+size_t SearchEngine::getDocumentCount() const {
+    EpochManager::Guard guard(epochs_);
+    return snapshot_.load()->getTotalDocuments();
+}
+
+void SearchEngine::setImpactScoring(bool enabled) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    index_.setStoreImpacts(enabled);
+    publishSnapshot();
+}
+
+bool SearchEngine::getImpactScoring() const {
+    EpochManager::Guard guard(epochs_);
+    return snapshot_.load()->hasImpacts();
+}
+
+void SearchEngine::setPositionIndexing(bool enabled) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    if (enabled == index_.hasPositions()) return;
+    if (getBufferedDocuments() > 0) {
+        flushWriteBuffer();
+    }
+    index_.setStorePositions(enabled);
+    publishSnapshot();
+    scheduleMerge();
+}
+
+void SearchEngine::setResultCacheCapacity(size_t entries) {
+    result_cache_.setCapacity(entries);
+}
+
+size_t SearchEngine::getResultCacheCapacity() const {
+    return result_cache_.getCapacity();
+}
+
+ResultCache::Stats SearchEngine::getResultCacheStats() const {
+    return result_cache_.getStats();
+}
+
+bool SearchEngine::getPositionIndexing() const {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    return index_.hasPositions();
+}
+
+std::vector<std::pair<std::string, double>> SearchEngine::search(const std::string& query, size_t num_results) const {
+    Query parsed = Query::parse(query);
+    std::vector<std::pair<std::string, double>> results;
+    
+    {
+        // Pin the current snapshot; writers publish new ones instead of
+        // modifying it, and it is not freed while pinned
+        EpochManager::Guard guard(epochs_);
+        const IndexSnapshot& snapshot = *snapshot_.load();
+        
+        // Repeated queries against an unchanged index come from the cache.
+        // Results are cached per snapshot generation, so every published
+        // change invalidates them.
+        if (result_cache_.getCapacity() == 0) {
+            results = rank(snapshot, parsed, num_results);
+        }
+        else {
+            std::string key = parsed.normalized() + '#' + std::to_string(num_results);
+            if (auto cached = result_cache_.lookup(key, snapshot.getGeneration())) {
+                results = *cached;
+            }
+            else {
+                results = rank(snapshot, parsed, num_results);
+                result_cache_.insert(key, snapshot.getGeneration(), results);
+            }
+        }
     }
     
+    // Count the terms towards autocomplete popularity; the trie itself is
+    // updated in the background
+    query_log_.record(parsed.terms);
+    
     return results;
 }
 
-std::vector<std::string> SearchEngine::getAutocompleteSuggestions(const std::string& prefix) const {
-    return autocomplete_trie_->getSuggestions(prefix);
+std::vector<std::pair<std::string, double>> SearchEngine::rank(const IndexSnapshot& snapshot, const Query& parsed,
+                                                               size_t num_results) const {
+    std::vector<std::pair<std::string, double>> results;
+    std::vector<std::pair<uint32_t, double>> scored = select(snapshot, parsed, num_results);
+    results.reserve(scored.size());
+    for (const auto& [doc_id, score] : scored) {
+        results.emplace_back(snapshot.getDocumentId(doc_id), score);
+    }
+    return results;
 }
 
-std::vector<std::string> SearchEngine::getSpellingSuggestions(const std::string& word) const {
-    return spell_corrector_->getSuggestions(word);
+std::vector<std::pair<uint32_t, double>> SearchEngine::select(const IndexSnapshot& snapshot, const Query& parsed,
+                                                              size_t num_results) const {
+    std::vector<std::pair<uint32_t, double>> scored;
+    if (parsed.filter) {
+        std::vector<uint32_t> matches = QueryEvaluator(snapshot).evaluate(*parsed.filter);
+        TopKCollector top_k(num_results, matches.size());
+        for (const auto& [doc_id, score] : scoreMatches(snapshot, parsed.terms, matches)) {
+            top_k.offer(doc_id, score);
+        }
+        scored = top_k.takeSorted();
+    }
+    else if (scoring_strategy_.load(std::memory_order_relaxed) == ScoringStrategy::BlockMaxWand) {
+        scored = scoreBlockMaxWand(snapshot, parsed.terms, num_results);
+    }
+    else {
+        scored = scoreTermAtATime(snapshot, parsed.terms, num_results);
+    }
+    return scored;
 }
 
-bool SearchEngine::saveIndex(const std::string& filename) const {
-    // Serialize index data
-    std::stringstream ss;
+SearchResultIterator SearchEngine::searchIterator(const std::string& query) const {
+    Query parsed = Query::parse(query);
+    
+    // The iterator keeps the snapshot pinned while it is alive
+    EpochManager::Guard guard(epochs_);
+    const IndexSnapshot& snapshot = *snapshot_.load();
+    
+    query_log_.record(parsed.terms);
+    
+    // Boolean matches are all scored anyway, so score them once, on the
+    // first batch; each later batch only sorts the next stretch of them
+    if (parsed.filter) {
+        auto selectBest = [this, &snapshot, parsed = std::move(parsed), scored = std::vector<TopKCollector::Entry>(),
+                           sorted = size_t{0}, evaluated = false](size_t k) mutable {
+            if (!evaluated) {
+                scored = scoreMatches(snapshot, parsed.terms, QueryEvaluator(snapshot).evaluate(*parsed.filter));
+                evaluated = true;
+            }
+            // Entries before sorted are final and beat every later one
+            size_t end = std::min(k, scored.size());
+            if (end > sorted) {
+                std::partial_sort(scored.begin() + sorted, scored.begin() + end, scored.end(), TopKCollector::better);
+                sorted = end;
+            }
+            return std::vector<TopKCollector::Entry>(scored.begin(), scored.begin() + end);
+        };
+        return SearchResultIterator(std::move(guard), snapshot, std::move(selectBest));
+    }
     
-    // Save document count
-    size_t doc_count = documents_.size();
-    ss.write(reinterpret_cast<const char*>(&doc_count), sizeof(doc_count));
+    // Batches are selected with the strategy current at each refill; both
+    // strategies rank identically
+    auto selectBest = [this, &snapshot, parsed = std::move(parsed)](size_t k) {
+        return select(snapshot, parsed, k);
+    };
+    return SearchResultIterator(std::move(guard), snapshot, std::move(selectBest));
+}
+
+void SearchEngine::accumulateScores(const IndexSnapshot& snapshot, const std::vector<std::string>& query_terms,
+                                    ScoreAccumulator& accumulator) const {
+    // Term-at-a-time evaluation: only documents on a query term's posting
+    // list are visited, so cost tracks posting length, not corpus size.
+    accumulator.reset(snapshot.getTotalDocuments());
+    const TFIDFCalculator& calculator = snapshot.getCalculator();
+    std::vector<IndexSnapshot::TermPostings> parts;
     
-    // Save documents
-    for (const auto& doc : documents_) {
-        const auto& id = doc->getId();
-        const auto& path = doc->getPath();
+    for (const auto& term : query_terms) {
+        parts.clear();
+        double idf = snapshot.lookupTerm(term, parts);
+        if (idf <= 0.0) continue;  // Unknown, or occurs in every document
         
-        size_t id_length = id.length();
-        size_t path_length = path.length();
+        // Decode the compressed lists a block at a time into local buffers
+        uint32_t doc_ids[PostingList::kBlockSize];
+        uint32_t term_frequencies[PostingList::kBlockSize];
         
-        ss.write(reinterpret_cast<const char*>(&id_length), sizeof(id_length));
-        ss.write(id.c_str(), id_length);
-        ss.write(reinterpret_cast<const char*>(&path_length), sizeof(path_length));
-        ss.write(path.c_str(), path_length);
+        for (const auto& part : parts) {
+            const PostingList::View& postings = part.postings;
+            for (size_t b = 0; b < postings.num_blocks; ++b) {
+                size_t count = postings.decodeDocIds(b, doc_ids);
+                if (part.impacts) {
+                    const uint8_t* block_impacts = part.impacts + b * PostingList::kBlockSize;
+                    for (size_t i = 0; i < count; ++i) {
+                        accumulator.add(part.base + doc_ids[i], TFIDFCalculator::impactWeight(block_impacts[i]) * idf);
+                    }
+                }
+                else {
+                    postings.decodeTermFrequencies(b, term_frequencies);
+                    for (size_t i = 0; i < count; ++i) {
+                        accumulator.add(part.base + doc_ids[i], calculator.calculateTF(term_frequencies[i]) * idf);
+                    }
+                }
+            }
+        }
+    }
+}
+
+std::vector<std::pair<uint32_t, double>> SearchEngine::scoreTermAtATime(
+        const IndexSnapshot& snapshot, const std::vector<std::string>& query_terms, size_t num_results) const {
+    // Each thread reuses its accumulator to avoid per-query allocation
+    thread_local ScoreAccumulator accumulator;
+    accumulateScores(snapshot, query_terms, accumulator);
+    
+    // Keep only the best num_results in a bounded heap instead of sorting
+    // every candidate
+    TopKCollector top_k(num_results, accumulator.getTouched().size());
+    for (uint32_t doc_id : accumulator.getTouched()) {
+        top_k.offer(doc_id, accumulator.getScore(doc_id));
     }
     
-    // Compress and save
-    std::string data = ss.str();
-    auto compressed = compressor_->compress(data);
-    return compressor_->saveToFile(filename, compressed);
+    return top_k.takeSorted();
 }
 
-bool SearchEngine::loadIndex(const std::string& filename) {
-    auto compressed = compressor_->loadFromFile(filename);
-    if (compressed.empty()) return false;
+std::vector<std::pair<uint32_t, double>> SearchEngine::scoreBlockMaxWand(
+        const IndexSnapshot& snapshot, const std::vector<std::string>& query_terms, size_t num_results) const {
+    // Resolve every term once, with its IDF over the whole snapshot
+    std::vector<IndexSnapshot::TermPostings> postings;
+    std::vector<double> idfs;
+    for (const auto& term : query_terms) {
+        size_t first = postings.size();
+        double idf = snapshot.lookupTerm(term, postings);
+        if (idf <= 0.0) {
+            postings.resize(first);  // Unknown, or occurs in every document
+            continue;
+        }
+        idfs.resize(postings.size(), idf);
+    }
     
-    std::string data = compressor_->decompress(compressed);
-    std::stringstream ss(data);
+    // Each document lives in exactly one part, so the top documents are the
+    // best of the per-part top documents
+    BlockMaxWand evaluator(snapshot.getCalculator());
+    TopKCollector top_k(num_results);
+    for (size_t part = 0; part < snapshot.getPartCount(); ++part) {
+        std::vector<BlockMaxWand::Term> terms;
+        uint32_t base = 0;
+        for (size_t i = 0; i < postings.size(); ++i) {
+            if (postings[i].part != part) continue;
+            base = postings[i].base;
+            terms.push_back({PostingCursor(postings[i].postings, postings[i].impacts),
+                             idfs[i], postings[i].max_term_frequency});
+        }
+        if (terms.empty()) continue;
+        
+        for (const auto& [doc_id, score] : evaluator.search(std::move(terms), num_results)) {
+            top_k.offer(base + doc_id, score);
+        }
+    }
     
-    // Clear existing data
-    documents_.clear();
-    index_ = InvertedIndex();
-    autocomplete_trie_->clear();
-    spell_corrector_->clear();
+    return top_k.takeSorted();
+}
+
+std::vector<TopKCollector::Entry> SearchEngine::scoreMatches(const IndexSnapshot& snapshot,
+                                                             const std::vector<std::string>& query_terms,
+                                                             const std::vector<uint32_t>& matches) const {
+    // Probe each term's postings for the matching documents only, skipping
+    // the blocks between them
+    std::vector<double> scores(matches.size(), 0.0);
+    const TFIDFCalculator& calculator = snapshot.getCalculator();
+    std::vector<IndexSnapshot::TermPostings> parts;
+    for (const auto& term : query_terms) {
+        parts.clear();
+        double idf = snapshot.lookupTerm(term, parts);
+        if (idf <= 0.0) continue;  // Unknown, or occurs in every document
+        
+        for (const auto& part : parts) {
+            PostingCursor cursor(part.postings, part.impacts);
+            size_t i = static_cast<size_t>(std::lower_bound(matches.begin(), matches.end(), part.base) - matches.begin());
+            for (; i < matches.size(); ++i) {
+                uint32_t doc_id = matches[i] - part.base;
+                cursor.nextGEQ(doc_id);
+                if (cursor.docId() == PostingCursor::kEnd) break;
+                if (cursor.docId() != doc_id) continue;
+                double weight = cursor.hasImpacts() ? TFIDFCalculator::impactWeight(cursor.impact())
+                                                    : calculator.calculateTF(cursor.termFrequency());
+                scores[i] += weight * idf;
+            }
+        }
+    }
     
-    // Load document count
-    size_t doc_count;
-    ss.read(reinterpret_cast<char*>(&doc_count), sizeof(doc_count));
+    // Every match is a result, even one no term scores, e.g. for "NOT a"
+    std::vector<TopKCollector::Entry> scored;
+    scored.reserve(matches.size());
+    for (size_t i = 0; i < matches.size(); ++i) {
+        scored.emplace_back(matches[i], scores[i]);
+    }
+    return scored;
+}
+
+std::vector<std::string> SearchEngine::getAutocompleteSuggestions(const std::string& prefix) const {
+    std::shared_lock<std::shared_mutex> lock(helpers_mutex_);
+    return autocomplete_trie_->getSuggestions(prefix);
+}
+
+std::vector<std::string> SearchEngine::getFuzzyAutocompleteSuggestions(const std::string& prefix,
+                                                                      size_t max_distance) const {
+    std::shared_lock<std::shared_mutex> lock(helpers_mutex_);
+    return autocomplete_trie_->getFuzzySuggestions(prefix, max_distance);
+}
+
+std::vector<std::string> SearchEngine::getSpellingSuggestions(const std::string& word) const {
+    std::shared_lock<std::shared_mutex> lock(helpers_mutex_);
+    return spell_corrector_->getSuggestions(word);
+}
+
+bool SearchEngine::saveIndex(const std::string& filename, IndexCompression compression) const {
+    BinaryWriter header;
+    header.writeBytes(kIndexMagic, sizeof(kIndexMagic));
+    header.write(kIndexFormatVersion);
     
-    // Load documents
-    for (size_t i = 0; i < doc_count; ++i) {
-        size_t id_length, path_length;
-        ss.read(reinterpret_cast<char*>(&id_length), sizeof(id_length));
+    // Segments are immutable, so only the header and helpers are built
+    // under the locks; segment bytes are streamed out afterwards
+    IndexSnapshot::SegmentList segments;
+    {
+        // Hold off writers so the helpers match the saved index
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        std::shared_lock<std::shared_mutex> helpers_lock(helpers_mutex_);
         
-        std::string id(id_length, '\0');
-        ss.read(&id[0], id_length);
+        // Buffered documents are saved as segments too
+        segments = segments_;
+        segments.insert(segments.end(), buffer_chunks_.begin(), buffer_chunks_.end());
+        if (index_.getTotalDocuments() > 0) {
+            segments.push_back(IndexSegment::fromIndex(index_));
+        }
         
-        ss.read(reinterpret_cast<char*>(&path_length), sizeof(path_length));
-        std::string path(path_length, '\0');
-        ss.read(&path[0], path_length);
+        header.write(static_cast<uint32_t>(segments.size()));
+        size_t table = header.size();
+        header.padTo(table + segments.size() * 2 * sizeof(uint64_t));
+        autocomplete_trie_->serialize(header);
+        spell_corrector_->serialize(header);
         
-        // Add document
-        try {
-            addDocument(id, path);
+        // Segments follow at 8-byte aligned offsets
+        uint64_t offset = header.size();
+        for (size_t i = 0; i < segments.size(); ++i) {
+            offset = (offset + 7) / 8 * 8;
+            uint64_t size = segments[i]->bytes().size();
+            header.patch(table + 2 * i * sizeof(uint64_t), offset);
+            header.patch(table + (2 * i + 1) * sizeof(uint64_t), size);
+            offset += size;
         }
-        catch (const std::exception&) {
-            return false;
+    }
+    
+    std::string temporary = filename + ".tmp";
+    bool written;
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file) return false;
+        
+        std::unique_ptr<CompressedFile::Writer> compressor;
+        if (compression != IndexCompression::None) {
+            Codec::Id codec = compression == IndexCompression::Rans ? Codec::Id::Rans : Codec::Id::Huffman;
+            compressor = std::make_unique<CompressedFile::Writer>(file, *thread_pool_, *Codec::get(codec));
+        }
+        auto write = [&file, &compressor](const char* data, size_t size) {
+            if (compressor) {
+                compressor->write(data, size);
+            }
+            else {
+                file.write(data, static_cast<std::streamsize>(size));
+            }
+        };
+        
+        write(header.data().data(), header.size());
+        size_t position = header.size();
+        const char padding[8] = {};
+        for (const auto& segment : segments) {
+            write(padding, (8 - position % 8) % 8);
+            position = (position + 7) / 8 * 8;
+            std::string_view bytes = segment->bytes();
+            write(bytes.data(), bytes.size());
+            position += bytes.size();
         }
+        
+        written = compressor ? compressor->finish() : static_cast<bool>(file.flush());
     }
     
+    std::error_code error;
+    if (written) {
+        std::filesystem::rename(temporary, filename, error);
+    }
+    if (!written || error) {
+        std::remove(temporary.c_str());
+        return false;
+    }
     return true;
 }
 
-std::vector<std::string> SearchEngine::tokenizeQuery(const std::string& query) const {
-    std::vector<std::string> tokens;
-    std::istringstream iss(query);
-    std::string token;
+bool SearchEngine::loadIndex(const std::string& filename) {
+    // Segments are queried straight from the mapping and keep it alive;
+    // queries touch a few terms' postings, so read-ahead would be wasted
+    auto file = std::make_shared<MappedFile>();
+    if (!file->open(filename, MappedFile::Access::Random)) return false;
     
-    while (iss >> token) {
-        // Convert to lowercase and remove punctuation
-        std::string processed;
-        processed.reserve(token.length());
+    // Read everything before touching the engine
+    IndexSnapshot::SegmentList segments;
+    auto trie = std::make_unique<Trie>();
+    auto spell_corrector = std::make_unique<SpellCorrector>();
+    try {
+        // Compressed files are decoded into memory, which then owns the
+        // segments instead of the mapping
+        std::shared_ptr<const void> owner = file;
+        const char* data = file->data();
+        size_t size = file->size();
+        if (CompressedFile::isCompressed(data, size)) {
+            file->advise(MappedFile::Access::Sequential);  // Decoded in one pass
+            auto decoded = std::make_shared<const std::string>(CompressedFile::decompress(data, size, *thread_pool_));
+            owner = decoded;
+            data = decoded->data();
+            size = decoded->size();
+        }
         
-        for (char c : token) {
-            if (std::isalnum(c)) {
-                processed += std::tolower(c);
-            }
+        BinaryReader reader(data, size);
+        if (std::memcmp(reader.readBytes(sizeof(kIndexMagic)), kIndexMagic, sizeof(kIndexMagic)) != 0 ||
+            reader.read<uint32_t>() != kIndexFormatVersion) {
+            return false;
+        }
+        
+        uint32_t segment_count = reader.read<uint32_t>();
+        std::vector<std::pair<uint64_t, uint64_t>> table;
+        for (uint32_t i = 0; i < segment_count; ++i) {
+            uint64_t offset = reader.read<uint64_t>();
+            uint64_t segment_size = reader.read<uint64_t>();
+            table.emplace_back(offset, segment_size);
         }
         
-        if (!processed.empty()) {
-            tokens.push_back(processed);
+        trie->deserialize(reader);
+        spell_corrector->deserialize(reader);
+        
+        // Segments follow the helpers, in order and without overlap
+        uint64_t end = reader.offset();
+        for (const auto& [offset, segment_size] : table) {
+            if (offset < end || offset % 8 != 0 || offset > size || segment_size > size - offset) {
+                return false;
+            }
+            segments.push_back(std::make_shared<const IndexSegment>(owner, data + offset, segment_size));
+            end = offset + segment_size;
         }
     }
+    catch (const std::runtime_error&) {
+        return false;
+    }
+    catch (const std::bad_alloc&) {
+        return false;   // Sizes no damaged file should make us allocate
+    }
+    catch (const std::length_error&) {
+        return false;
+    }
     
-    return tokens;
-} 
\ No newline at end of file
+    // Queries see the old index until the loaded one is published
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    resetWriteIndex();
+    buffer_chunks_.clear();
+    segments_ = std::move(segments);
+    {
+        std::unique_lock<std::shared_mutex> helpers_lock(helpers_mutex_);
+        autocomplete_trie_ = std::move(trie);
+        spell_corrector_ = std::move(spell_corrector);
+    }
+    query_log_.republish();
+    publishSnapshot();
+    scheduleMerge();
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#include "SearchResultIterator.hpp"
+#include <stdexcept>
+
+namespace {
+
+// Size of the first batch; later batches double
+constexpr size_t kFirstBatch = 16;
+
+} // namespace
+
+SearchResultIterator::SearchResultIterator(EpochManager::Guard guard, const IndexSnapshot& snapshot,
+                                           Select select)
+    : guard_(std::move(guard)), snapshot_(&snapshot), select_(std::move(select)) {}
+
+bool SearchResultIterator::hasNext() const {
+    if (position_ < batch_.size()) return true;
+    if (batch_size_ > 0 && exhausted()) return false;
+
+    // The new batch starts with the results already pulled
+    batch_size_ = batch_size_ == 0 ? kFirstBatch : 2 * batch_size_;
+    batch_ = select_(batch_size_);
+    return position_ < batch_.size();
+}
+
+std::pair<std::string, double> SearchResultIterator::next() {
+    if (!hasNext()) {
+        throw std::out_of_range("No more search results");
+    }
+
+    auto [doc_id, score] = batch_[position_++];
+    return {std::string(snapshot_->getDocumentId(doc_id)), score};
+}
\ No newline at end of file
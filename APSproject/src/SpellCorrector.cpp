@@ -1,11 +1,106 @@
 #include "SpellCorrector.hpp"
+#include "LevenshteinAutomaton.hpp"
 #include <algorithm>
+#include <memory>
 
-void SpellCorrector::addWord(const std::string& word) {
-    dictionary_.insert(word);
+namespace {
+
+// The dictionary is rebuilt once pending words exceed the larger of these:
+// a fixed minimum, or a fraction of the dictionary, so that rebuilds cost
+// amortized O(1) per added word. Lookups scan the pending words, so the
+// minimum stays small.
+constexpr size_t kMinPendingWords = 1024;
+constexpr size_t kPendingFraction = 8;
+
+} // namespace
+
+void SpellCorrector::addWord(const std::string& word, size_t count) {
+    pending_[word] += static_cast<uint32_t>(count);
+    if (pending_.size() > std::max(kMinPendingWords, dictionary_.size() / kPendingFraction)) {
+        dictionary_ = merged();
+        pending_.clear();
+    }
+}
+
+TermDictionary SpellCorrector::merged() const {
+    // A word's position in the dictionary is its ID
+    std::vector<std::pair<std::string, uint32_t>> words;
+    words.reserve(dictionary_.size() + pending_.size());
+    dictionary_.forEach([this, &words](std::string_view term, uint32_t id) {
+        words.emplace_back(term, dictionary_.getFrequency(id));
+    });
+    
+    size_t frozen = words.size();
+    for (const auto& [word, count] : pending_) {
+        uint32_t id = dictionary_.find(word);
+        if (id != TermDictionary::kNotFound) {
+            words[id].second += count;
+        }
+        else {
+            words.emplace_back(word, count);
+        }
+    }
+    std::sort(words.begin() + frozen, words.end());
+    std::inplace_merge(words.begin(), words.begin() + frozen, words.end());
+    
+    std::vector<std::string_view> terms;
+    std::vector<uint32_t> frequencies;
+    terms.reserve(words.size());
+    frequencies.reserve(words.size());
+    for (const auto& [word, frequency] : words) {
+        terms.push_back(word);
+        frequencies.push_back(frequency);
+    }
+    return TermDictionary::build(terms, frequencies.data());
 }
 
-size_t SpellCorrector::levenshteinDistance(const std::string& s1, const std::string& s2) const {
+bool SpellCorrector::contains(const std::string& word) const {
+    return dictionary_.find(word) != TermDictionary::kNotFound || pending_.count(word) > 0;
+}
+
+size_t SpellCorrector::size() const {
+    size_t count = dictionary_.size();
+    for (const auto& entry : pending_) {
+        if (dictionary_.find(entry.first) == TermDictionary::kNotFound) ++count;
+    }
+    return count;
+}
+
+size_t SpellCorrector::memoryUsage() const {
+    size_t usage = dictionary_.memoryUsage() + pending_.bucket_count() * sizeof(void*);
+    for (const auto& entry : pending_) {
+        usage += sizeof(entry) + 2 * sizeof(void*) + entry.first.capacity();
+    }
+    return usage;
+}
+
+void SpellCorrector::clear() {
+    dictionary_ = TermDictionary();
+    pending_.clear();
+}
+
+void SpellCorrector::serialize(BinaryWriter& writer) const {
+    // The automaton is written as is, with the pending words merged in
+    TermDictionary dictionary = pending_.empty() ? dictionary_ : merged();
+    std::string_view bytes = dictionary.bytes();
+    writer.write(static_cast<uint64_t>(bytes.size()));
+    writer.writeBytes(bytes.data(), bytes.size());
+}
+
+void SpellCorrector::deserialize(BinaryReader& reader) {
+    uint64_t size = reader.read<uint64_t>();
+    const char* data = reader.readBytes(size);
+    
+    // Copy into an aligned buffer the dictionary can use in place. The
+    // copy reads every byte anyway, so check every state too.
+    auto bytes = std::make_shared<const std::string>(data, size);
+    TermDictionary dictionary(bytes, bytes->data(), bytes->size());
+    dictionary.validate();
+    dictionary_ = std::move(dictionary);
+    pending_.clear();
+}
+
+size_t SpellCorrector::levenshteinDistance(std::string_view s1, std::string_view s2) const {
     const size_t m = s1.length();
     const size_t n = s2.length();
     
@@ -32,30 +127,67 @@ size_t SpellCorrector::levenshteinDistance(const std::string& s1, const std::str
 }
 
 std::vector<std::string> SpellCorrector::generateCandidates(const std::string& word) const {
-    std::vector<std::string> candidates;
+    struct Candidate {
+        size_t distance;
+        uint32_t frequency;
+        std::string word;
+    };
+    std::vector<Candidate> candidates;
+    
+    // Walk the dictionary with a Levenshtein automaton, which skips every
+    // branch that cannot come within max_distance_, adding pending counts
+    LevenshteinAutomaton automaton(word, max_distance_);
+    dictionary_.intersect(automaton, [&](std::string_view term, uint32_t id) {
+        uint32_t frequency = dictionary_.getFrequency(id);
+        auto it = pending_.find(std::string(term));
+        if (it != pending_.end()) frequency += it->second;
+        candidates.push_back({levenshteinDistance(word, term), frequency, std::string(term)});
+    });
     
-    // Check dictionary words within max_distance_
-    for (const auto& dict_word : dictionary_) {
-        size_t distance = levenshteinDistance(word, dict_word);
-        if (distance <= max_distance_) {
-            candidates.push_back(dict_word);
+    // Pending words are scanned: skip those whose length alone is too far
+    // off, and stop stepping the automaton once a word cannot match
+    LevenshteinAutomaton::State state;
+    LevenshteinAutomaton::State next;
+    for (const auto& [pending_word, count] : pending_) {
+        size_t shorter = std::min(word.size(), pending_word.size());
+        size_t longer = std::max(word.size(), pending_word.size());
+        if (longer - shorter > max_distance_) continue;
+        
+        state = automaton.start();
+        bool alive = true;
+        for (unsigned char c : pending_word) {
+            automaton.step(state, c, next);
+            state.swap(next);
+            if (!automaton.canMatch(state)) {
+                alive = false;
+                break;
+            }
+        }
+        if (alive && automaton.isMatch(state) && dictionary_.find(pending_word) == TermDictionary::kNotFound) {
+            candidates.push_back({automaton.distance(state), count, pending_word});
         }
     }
     
-    // Sort by edit distance
-    std::sort(candidates.begin(), candidates.end(),
-              [this, &word](const std::string& a, const std::string& b) {
-                  return levenshteinDistance(word, a) < levenshteinDistance(word, b);
-              });
+    // Sort by edit distance, then by frequency
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        if (a.distance != b.distance) return a.distance < b.distance;
+        if (a.frequency != b.frequency) return a.frequency > b.frequency;
+        return a.word < b.word;
+    });
     
-    return candidates;
+    std::vector<std::string> suggestions;
+    suggestions.reserve(candidates.size());
+    for (auto& candidate : candidates) {
+        suggestions.push_back(std::move(candidate.word));
+    }
+    return suggestions;
 }
 
 std::vector<std::string> SpellCorrector::getSuggestions(const std::string& word) const {
     // If word exists in dictionary, return empty suggestions
-    if (dictionary_.find(word) != dictionary_.end()) {
+    if (contains(word)) {
         return {};
     }
     
     return generateCandidates(word);
-} 
\ No newline at end of file
+}
\ No newline at end of file
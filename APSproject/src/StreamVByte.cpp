@@ -0,0 +1,155 @@
+#include "StreamVByte.hpp"
+#include "CpuFeatures.hpp"
+#include <cstring>
+
+#ifdef SEARCH_ENGINE_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+uint8_t encodedLength(uint32_t value) {
+    if (value < (1u << 8)) return 1;
+    if (value < (1u << 16)) return 2;
+    if (value < (1u << 24)) return 3;
+    return 4;
+}
+
+template <bool Delta>
+size_t encodeImpl(const uint32_t* in, size_t n, uint32_t previous, uint8_t* out) {
+    uint8_t* control = out;
+    uint8_t* data = out + (n + 3) / 4;
+    std::memset(control, 0, (n + 3) / 4);
+
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t value = Delta ? in[i] - previous : in[i];
+        if (Delta) previous = in[i];
+
+        uint8_t length = encodedLength(value);
+        control[i / 4] |= static_cast<uint8_t>((length - 1) << (2 * (i % 4)));
+        for (uint8_t b = 0; b < length; ++b) {
+            *data++ = static_cast<uint8_t>(value >> (8 * b));
+        }
+    }
+    return static_cast<size_t>(data - out);
+}
+
+// Scalar decoding of values [first, n); returns the data pointer after them
+template <bool Delta>
+const uint8_t* decodeScalar(const uint8_t* control, const uint8_t* data, size_t first, size_t n,
+                            uint32_t previous, uint32_t* out) {
+    for (size_t i = first; i < n; ++i) {
+        uint8_t length = ((control[i / 4] >> (2 * (i % 4))) & 3) + 1;
+        uint32_t value = 0;
+        for (uint8_t b = 0; b < length; ++b) {
+            value |= static_cast<uint32_t>(data[b]) << (8 * b);
+        }
+        data += length;
+        if (Delta) {
+            previous += value;
+            value = previous;
+        }
+        out[i] = value;
+    }
+    return data;
+}
+
+#ifdef SEARCH_ENGINE_X86
+
+// Shuffle masks and data lengths for every control byte
+struct ShuffleTables {
+    alignas(16) uint8_t masks[256][16];
+    uint8_t lengths[256];
+
+    ShuffleTables() {
+        for (int control = 0; control < 256; ++control) {
+            uint8_t offset = 0;
+            for (int value = 0; value < 4; ++value) {
+                uint8_t length = ((control >> (2 * value)) & 3) + 1;
+                for (uint8_t b = 0; b < 4; ++b) {
+                    masks[control][4 * value + b] = b < length ? offset + b : 0x80;
+                }
+                offset += length;
+            }
+            lengths[control] = offset;
+        }
+    }
+};
+
+const ShuffleTables& shuffleTables() {
+    static const ShuffleTables tables;
+    return tables;
+}
+
+template <bool Delta>
+SEARCH_ENGINE_TARGET("ssse3")
+size_t decodeSSSE3(const uint8_t* in, size_t n, uint32_t previous, uint32_t* out, const uint8_t* limit) {
+    const ShuffleTables& tables = shuffleTables();
+    const uint8_t* control = in;
+    const uint8_t* data = in + (n + 3) / 4;
+
+    __m128i running = _mm_set1_epi32(static_cast<int>(previous));
+    size_t i = 0;
+    for (; i + 4 <= n && data + 16 <= limit; i += 4) {
+        uint8_t c = control[i / 4];
+        __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+        values = _mm_shuffle_epi8(values, _mm_load_si128(reinterpret_cast<const __m128i*>(tables.masks[c])));
+        data += tables.lengths[c];
+
+        if (Delta) {
+            // In-register prefix sum of the four gaps, then add the carry
+            values = _mm_add_epi32(values, _mm_slli_si128(values, 4));
+            values = _mm_add_epi32(values, _mm_slli_si128(values, 8));
+            values = _mm_add_epi32(values, running);
+            running = _mm_shuffle_epi32(values, 0xFF);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), values);
+    }
+
+    if (Delta && i > 0) previous = out[i - 1];
+    data = decodeScalar<Delta>(control, data, i, n, previous, out);
+    return static_cast<size_t>(data - in);
+}
+
+#endif // SEARCH_ENGINE_X86
+
+template <bool Delta>
+size_t decodeImpl(const uint8_t* in, size_t n, uint32_t previous, uint32_t* out, const uint8_t* limit) {
+#ifdef SEARCH_ENGINE_X86
+    static const bool use_ssse3 = CpuFeatures::hasSSSE3();
+    if (use_ssse3) {
+        return decodeSSSE3<Delta>(in, n, previous, out, limit);
+    }
+#else
+    (void)limit;
+#endif
+    const uint8_t* data = decodeScalar<Delta>(in, in + (n + 3) / 4, 0, n, previous, out);
+    return static_cast<size_t>(data - in);
+}
+
+} // namespace
+
+size_t StreamVByte::encodedSize(const uint8_t* in, size_t n) {
+    size_t size = (n + 3) / 4;
+    for (size_t i = 0; i < n; ++i) {
+        size += ((in[i / 4] >> (2 * (i % 4))) & 3) + 1;
+    }
+    return size;
+}
+
+size_t StreamVByte::encode(const uint32_t* in, size_t n, uint8_t* out) {
+    return encodeImpl<false>(in, n, 0, out);
+}
+
+size_t StreamVByte::encodeDelta(const uint32_t* in, size_t n, uint32_t previous, uint8_t* out) {
+    return encodeImpl<true>(in, n, previous, out);
+}
+
+size_t StreamVByte::decode(const uint8_t* in, size_t n, uint32_t* out, const uint8_t* limit) {
+    return decodeImpl<false>(in, n, 0, out, limit);
+}
+
+size_t StreamVByte::decodeDelta(const uint8_t* in, size_t n, uint32_t previous, uint32_t* out,
+                                const uint8_t* limit) {
+    return decodeImpl<true>(in, n, previous, out, limit);
+}
\ No newline at end of file
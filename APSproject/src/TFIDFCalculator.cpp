@@ -1,25 +1,68 @@
 #include "TFIDFCalculator.hpp"
+#include <array>
+#include <algorithm>
+
+namespace {
+
+// Logarithmic TF weights for the small frequencies that dominate postings
+constexpr size_t kTFTableSize = 256;
+
+const std::array<double, kTFTableSize>& tfTable() {
+    static const std::array<double, kTFTableSize> table = [] {
+        std::array<double, kTFTableSize> weights{};
+        for (size_t tf = 1; tf < kTFTableSize; ++tf) {
+            weights[tf] = 1.0 + std::log(static_cast<double>(tf));
+        }
+        return weights;
+    }();
+    return table;
+}
+
+} // namespace
 
 double TFIDFCalculator::calculateTF(const std::string& term, const Document& doc) const {
-    const auto& frequencies = doc.getWordFrequencies();
-    auto it = frequencies.find(term);
-    if (it == frequencies.end()) {
+    const auto& occurrences = doc.getWordOccurrences();
+    auto it = occurrences.find(term);
+    if (it == occurrences.end()) {
         return 0.0;
     }
     
+    return calculateTF(it->second.frequency);
+}
+
+double TFIDFCalculator::calculateTF(size_t term_frequency) const {
+    if (index_.hasImpacts()) {
+        return impactWeight(quantizeTF(term_frequency));
+    }
+    if (term_frequency < kTFTableSize) {
+        return tfTable()[term_frequency];
+    }
+    
     // Using logarithmic TF to prevent bias towards longer documents
-    return 1.0 + std::log(static_cast<double>(it->second));
+    return 1.0 + std::log(static_cast<double>(term_frequency));
+}
+
+uint8_t TFIDFCalculator::quantizeTF(size_t term_frequency) {
+    if (term_frequency == 0) {
+        return 0;
+    }
+    
+    double weight = 1.0 + std::log(static_cast<double>(term_frequency));
+    return static_cast<uint8_t>(std::min(255.0, std::round(weight / kImpactStep)));
 }
 
 double TFIDFCalculator::calculateIDF(const std::string& term) const {
-    size_t doc_freq = index_.getDocumentFrequency(term);
-    if (doc_freq == 0) {
+    return calculateIDF(index_.getDocumentFrequency(term));
+}
+
+double TFIDFCalculator::calculateIDF(size_t document_frequency) const {
+    if (document_frequency == 0) {
         return 0.0;
     }
     
     // Calculate IDF using the standard formula: log(N/df)
     double total_docs = static_cast<double>(index_.getTotalDocuments());
-    return std::log(total_docs / static_cast<double>(doc_freq));
+    return std::log(total_docs / static_cast<double>(document_frequency));
 }
 
 double TFIDFCalculator::calculateTFIDF(const std::string& term, const Document& doc) const {
@@ -0,0 +1,427 @@
+#include "TermDictionary.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+// Arc lists up to this length are scanned linearly, longer ones searched
+constexpr uint32_t kLinearScanLimit = 16;
+
+// State flags
+constexpr uint8_t kFinal = 1;
+constexpr uint8_t kHasArcs = 2;
+constexpr int kTargetWidthShift = 2;
+constexpr int kRankWidthShift = 4;
+constexpr uint8_t kSingleArc = 64;
+constexpr uint8_t kLastIsNext = 128;
+
+[[noreturn]] void corrupt() {
+    throw std::runtime_error("Corrupt term dictionary");
+}
+
+uint8_t byteWidth(uint64_t value) {
+    if (value < (1u << 8)) return 1;
+    if (value < (1u << 16)) return 2;
+    if (value < (1u << 24)) return 3;
+    if (value <= UINT32_MAX) return 4;
+    throw std::runtime_error("Term dictionary is too large");
+}
+
+void appendValue(std::string& out, uint32_t value, uint8_t width) {
+    for (uint8_t b = 0; b < width; ++b) {
+        out.push_back(static_cast<char>(value >> (8 * b)));
+    }
+}
+
+uint32_t readValue(const uint8_t* in, uint8_t width) {
+    uint32_t value = 0;
+    for (uint8_t b = 0; b < width; ++b) {
+        value |= static_cast<uint32_t>(in[b]) << (8 * b);
+    }
+    return value;
+}
+
+// Incremental construction from sorted terms: the path of the last term
+// stays open, and each node leaving it is frozen into an equivalent state
+// if one exists, so the automaton is minimal when the input ends. States
+// are encoded children first and laid out in reverse, so that the root
+// comes first and every target lies after its parent.
+class Builder {
+public:
+    struct Node {
+        bool final{false};
+        std::vector<std::pair<unsigned char, uint32_t>> arcs;
+    };
+
+    uint32_t freeze(const Node& node) {
+        std::string key(1, node.final ? '\1' : '\0');
+        for (const auto& [label, target] : node.arcs) {
+            key.push_back(static_cast<char>(label));
+            key.append(reinterpret_cast<const char*>(&target), sizeof(target));
+        }
+        auto [it, inserted] = registry_.try_emplace(std::move(key), static_cast<uint32_t>(ends_.size()));
+        if (inserted) {
+            encode(node);
+        }
+        return it->second;
+    }
+
+    // The states in final order
+    std::string assemble() const {
+        std::string automaton;
+        automaton.reserve(encoded_.size());
+        for (size_t state = ends_.size(); state-- > 0;) {
+            size_t start = state > 0 ? ends_[state - 1] : 0;
+            automaton.append(encoded_, start, ends_[state] - start);
+        }
+        return automaton;
+    }
+
+private:
+    std::unordered_map<std::string, uint32_t> registry_;
+    std::string encoded_;           // States in creation order
+    std::vector<size_t> ends_;      // End of each state in encoded_
+    std::vector<uint32_t> counts_;  // Terms reachable from each state
+
+    void encode(const Node& node) {
+        // Once reversed, a target starts start - end(target) bytes after
+        // the end of this state
+        size_t start = encoded_.size();
+        size_t num_arcs = node.arcs.size();
+        std::vector<uint32_t> offsets, ranks;
+        uint32_t count = node.final ? 1 : 0;
+        for (const auto& [label, target] : node.arcs) {
+            offsets.push_back(static_cast<uint32_t>(start - ends_[target]));
+            ranks.push_back(count);
+            count += counts_[target];
+        }
+        bool last_is_next = num_arcs > 0 && offsets.back() == 0;
+        size_t stored_targets = last_is_next ? num_arcs - 1 : num_arcs;
+        uint8_t target_width = byteWidth(stored_targets > 0 ? *std::max_element(offsets.begin(), offsets.begin() + stored_targets) : 0);
+        uint8_t rank_width = byteWidth(num_arcs > 1 ? ranks.back() : 0);
+
+        uint8_t flags = (node.final ? kFinal : 0) | (num_arcs > 0 ? kHasArcs : 0) |
+                        ((target_width - 1) << kTargetWidthShift) | ((rank_width - 1) << kRankWidthShift) |
+                        (num_arcs == 1 ? kSingleArc : 0) | (last_is_next ? kLastIsNext : 0);
+        encoded_.push_back(static_cast<char>(flags));
+        if (num_arcs > 1) {
+            encoded_.push_back(static_cast<char>(num_arcs - 1));
+        }
+        for (const auto& arc : node.arcs) {
+            encoded_.push_back(static_cast<char>(arc.first));
+        }
+        for (size_t i = 0; i < stored_targets; ++i) {
+            appendValue(encoded_, offsets[i], target_width);
+        }
+        for (size_t i = 1; i < num_arcs; ++i) {
+            appendValue(encoded_, ranks[i], rank_width);
+        }
+        ends_.push_back(encoded_.size());
+        counts_.push_back(count);
+    }
+};
+
+} // namespace
+
+TermDictionary::TermDictionary() : TermDictionary(empty()) {}
+
+const TermDictionary& TermDictionary::empty() {
+    static const TermDictionary dictionary = build({});
+    return dictionary;
+}
+
+TermDictionary::TermDictionary(std::shared_ptr<const void> owner, const char* data, size_t size)
+    : owner_(std::move(owner)) {
+    if (size < sizeof(Header) || reinterpret_cast<uintptr_t>(data) % alignof(Header) != 0) {
+        corrupt();
+    }
+    header_ = reinterpret_cast<const Header*>(data);
+    const Header& h = *header_;
+    bool has_frequencies = (h.flags & kHasFrequencies) != 0;
+    uint64_t frequencies_size = has_frequencies ? uint64_t{h.term_count} * sizeof(uint32_t) : 0;
+    if (h.automaton_size == 0 || h.automaton_size > size ||
+        sizeof(Header) + frequencies_size > size - h.automaton_size) {
+        corrupt();
+    }
+    size_ = static_cast<size_t>(sizeof(Header) + frequencies_size + h.automaton_size);
+
+    frequencies_ = has_frequencies ? reinterpret_cast<const uint32_t*>(data + sizeof(Header)) : nullptr;
+    automaton_ = reinterpret_cast<const uint8_t*>(data + sizeof(Header) + frequencies_size);
+    automaton_size_ = static_cast<size_t>(h.automaton_size);
+}
+
+void TermDictionary::write(const std::vector<std::string_view>& terms, const uint32_t* frequencies,
+                           BinaryWriter& writer) {
+    if (terms.size() >= kNotFound) {
+        throw std::runtime_error("Term dictionary is too large");
+    }
+
+    Builder builder;
+    std::vector<Builder::Node> path(1);
+    auto freezeLast = [&builder, &path]() {
+        uint32_t state = builder.freeze(path.back());
+        path.pop_back();
+        path.back().arcs.back().second = state;
+    };
+    for (size_t i = 0; i < terms.size(); ++i) {
+        std::string_view term = terms[i];
+        size_t common = 0;
+        if (i > 0) {
+            if (term <= terms[i - 1]) {
+                throw std::invalid_argument("Dictionary terms must be sorted and unique");
+            }
+            std::string_view previous = terms[i - 1];
+            while (common < previous.size() && common < term.size() && previous[common] == term[common]) {
+                ++common;
+            }
+        }
+
+        // The previous term's path below the shared prefix is complete
+        while (path.size() > common + 1) {
+            freezeLast();
+        }
+        for (size_t j = common; j < term.size(); ++j) {
+            path.back().arcs.emplace_back(static_cast<unsigned char>(term[j]), 0);
+            path.emplace_back();
+        }
+        path.back().final = true;
+    }
+    while (path.size() > 1) {
+        freezeLast();
+    }
+    builder.freeze(path.front());
+    std::string automaton = builder.assemble();
+
+    Header header{};
+    header.term_count = static_cast<uint32_t>(terms.size());
+    header.flags = frequencies ? kHasFrequencies : 0;
+    header.automaton_size = automaton.size();
+
+    writer.align(alignof(Header));
+    writer.write(header);
+    if (frequencies) {
+        writer.writeBytes(frequencies, terms.size() * sizeof(uint32_t));
+    }
+    writer.writeBytes(automaton.data(), automaton.size());
+}
+
+TermDictionary TermDictionary::build(const std::vector<std::string_view>& terms, const uint32_t* frequencies) {
+    BinaryWriter writer;
+    write(terms, frequencies, writer);
+    auto bytes = std::make_shared<const std::string>(writer.data());
+    return TermDictionary(bytes, bytes->data(), bytes->size());
+}
+
+TermDictionary::State TermDictionary::decode(size_t address) const {
+    if (address >= automaton_size_) {
+        corrupt();
+    }
+    const uint8_t* p = automaton_ + address;
+    const uint8_t* end = automaton_ + automaton_size_;
+    uint8_t flags = *p++;
+
+    State state{};
+    state.final = (flags & kFinal) != 0;
+    if (flags & kHasArcs) {
+        if (flags & kSingleArc) {
+            state.num_arcs = 1;
+        }
+        else {
+            if (p == end) corrupt();
+            state.num_arcs = *p++ + 1u;
+        }
+    }
+    state.target_width = ((flags >> kTargetWidthShift) & 3) + 1;
+    state.rank_width = ((flags >> kRankWidthShift) & 3) + 1;
+    state.last_is_next = state.num_arcs > 0 && (flags & kLastIsNext) != 0;
+
+    size_t stored_targets = state.num_arcs - (state.last_is_next ? 1 : 0);
+    size_t stored_ranks = state.num_arcs > 0 ? state.num_arcs - 1 : 0;
+    size_t length = state.num_arcs + stored_targets * state.target_width + stored_ranks * state.rank_width;
+    if (static_cast<size_t>(end - p) < length) {
+        corrupt();
+    }
+    state.labels = p;
+    state.targets = p + state.num_arcs;
+    state.ranks = state.targets + stored_targets * state.target_width;
+    state.end = static_cast<size_t>(p + length - automaton_);
+    return state;
+}
+
+size_t TermDictionary::target(const State& state, uint32_t arc) const {
+    if (state.last_is_next && arc + 1 == state.num_arcs) {
+        return state.end;
+    }
+    return state.end + readValue(state.targets + arc * state.target_width, state.target_width);
+}
+
+uint32_t TermDictionary::rank(const State& state, uint32_t arc) const {
+    if (arc == 0) {
+        return state.final ? 1 : 0;
+    }
+    return readValue(state.ranks + (arc - 1) * state.rank_width, state.rank_width);
+}
+
+uint32_t TermDictionary::findArc(const State& state, unsigned char c) const {
+    const uint8_t* begin = state.labels;
+    const uint8_t* end = state.labels + state.num_arcs;
+    const uint8_t* it = begin;
+    if (state.num_arcs <= kLinearScanLimit) {
+        while (it != end && *it < c) ++it;
+    }
+    else {
+        it = std::lower_bound(begin, end, c);
+    }
+    return it != end && *it == c ? static_cast<uint32_t>(it - begin) : kNotFound;
+}
+
+uint32_t TermDictionary::countTerms(State state) const {
+    // Terms before those through the last arc, plus those through it
+    uint32_t count = 0;
+    while (state.num_arcs > 0) {
+        count += rank(state, state.num_arcs - 1);
+        state = decode(target(state, state.num_arcs - 1));
+    }
+    return count + (state.final ? 1 : 0);
+}
+
+void TermDictionary::validate() const {
+    // Depth-first over the states, counting the terms below each; targets
+    // always point forward, so the walk ends, and shared states are
+    // counted once
+    struct Frame {
+        size_t address;
+        State state;
+        uint32_t arc;
+        uint64_t count;     // Terms through the state and its earlier arcs
+    };
+    std::unordered_map<size_t, uint32_t> counts;
+    std::vector<Frame> stack;
+    auto enter = [this, &stack](size_t address) {
+        State state = decode(address);
+        for (uint32_t arc = 1; arc < state.num_arcs; ++arc) {
+            if (state.labels[arc - 1] >= state.labels[arc]) corrupt();
+        }
+        stack.push_back({address, state, 0, state.final ? 1u : 0u});
+    };
+
+    enter(0);
+    uint64_t total = 0;
+    while (!stack.empty()) {
+        Frame& frame = stack.back();
+        if (frame.count > size()) corrupt();
+        if (frame.arc == frame.state.num_arcs) {
+            size_t address = frame.address;
+            uint32_t count = static_cast<uint32_t>(frame.count);
+            stack.pop_back();
+            if (stack.empty()) {
+                total = count;
+                break;
+            }
+            if (count == 0) corrupt();
+            counts.emplace(address, count);
+            stack.back().count += count;
+            ++stack.back().arc;
+            continue;
+        }
+
+        if (rank(frame.state, frame.arc) != frame.count) corrupt();
+        size_t address = target(frame.state, frame.arc);
+        auto it = counts.find(address);
+        if (it != counts.end()) {
+            frame.count += it->second;
+            ++frame.arc;
+        }
+        else {
+            enter(address);
+        }
+    }
+    if (total != size()) corrupt();
+}
+
+uint32_t TermDictionary::find(std::string_view term) const {
+    State state = decode(0);
+    uint32_t id = 0;
+    for (char c : term) {
+        uint32_t arc = findArc(state, static_cast<unsigned char>(c));
+        if (arc == kNotFound) return kNotFound;
+        id += rank(state, arc);
+        state = decode(target(state, arc));
+    }
+    return state.final ? id : kNotFound;
+}
+
+std::string TermDictionary::getTerm(uint32_t id) const {
+    if (id >= size()) {
+        throw std::out_of_range("Term ID out of range");
+    }
+
+    // Follow the last arc whose rank does not exceed the remaining rank
+    std::string term;
+    State state = decode(0);
+    while (!(state.final && id == 0)) {
+        if (state.num_arcs == 0) corrupt();
+        uint32_t low = 0;
+        uint32_t high = state.num_arcs;
+        while (high - low > 1) {
+            uint32_t middle = low + (high - low) / 2;
+            if (rank(state, middle) <= id) {
+                low = middle;
+            }
+            else {
+                high = middle;
+            }
+        }
+        uint32_t arc_rank = rank(state, low);
+        if (arc_rank > id) corrupt();
+        id -= arc_rank;
+        term.push_back(static_cast<char>(state.labels[low]));
+        state = decode(target(state, low));
+    }
+    return term;
+}
+
+uint32_t TermDictionary::lowerBound(std::string_view term) const {
+    State state = decode(0);
+    uint32_t id = 0;
+    for (char c : term) {
+        unsigned char label = static_cast<unsigned char>(c);
+        uint32_t arc = findArc(state, label);
+        if (arc != kNotFound) {
+            id += rank(state, arc);
+            state = decode(target(state, arc));
+            continue;
+        }
+
+        // The term leaves the automaton here: it sorts after the terms
+        // through smaller labels and before those through larger ones
+        const uint8_t* larger = std::upper_bound(state.labels, state.labels + state.num_arcs, label);
+        if (larger != state.labels + state.num_arcs) {
+            return id + rank(state, static_cast<uint32_t>(larger - state.labels));
+        }
+        return id + countTerms(state);
+    }
+    return id;
+}
+
+std::pair<uint32_t, uint32_t> TermDictionary::prefixRange(std::string_view prefix) const {
+    State state = decode(0);
+    uint32_t id = 0;
+    for (char c : prefix) {
+        uint32_t arc = findArc(state, static_cast<unsigned char>(c));
+        if (arc == kNotFound) {
+            uint32_t position = lowerBound(prefix);
+            return {position, position};
+        }
+        id += rank(state, arc);
+        state = decode(target(state, arc));
+    }
+    return {id, id + countTerms(state)};
+}
+
+std::pair<uint32_t, uint32_t> TermDictionary::range(std::string_view low, std::string_view high) const {
+    uint32_t first = lowerBound(low);
+    return {first, std::max(first, lowerBound(high))};
+}
\ No newline at end of file
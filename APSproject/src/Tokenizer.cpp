@@ -0,0 +1,298 @@
+#include "Tokenizer.hpp"
+#include "CpuFeatures.hpp"
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#ifdef SEARCH_ENGINE_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+constexpr size_t kBlockBytes = 64;
+
+// Index of the lowest set bit of a non-zero mask
+size_t lowestBit(uint64_t mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return index;
+#else
+    return static_cast<size_t>(__builtin_ctzll(mask));
+#endif
+}
+
+// Byte classes, matching the "C" locale for ASCII and dropping other bytes
+bool isSpace(unsigned char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+bool isLowerAlnum(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9');
+}
+
+// Lowercased letter or digit, or 0 for bytes that are dropped
+unsigned char foldByte(unsigned char c) {
+    if (c >= 'A' && c <= 'Z') return static_cast<unsigned char>(c + ('a' - 'A'));
+    return isLowerAlnum(c) ? c : 0;
+}
+
+// Whitespace and normalized-byte masks for n <= 64 bytes
+void classifyScalar(const char* in, size_t n, uint64_t& space, uint64_t& clean) {
+    space = 0;
+    clean = 0;
+    for (size_t i = 0; i < n; ++i) {
+        unsigned char c = static_cast<unsigned char>(in[i]);
+        space |= static_cast<uint64_t>(isSpace(c)) << i;
+        clean |= static_cast<uint64_t>(isLowerAlnum(c)) << i;
+    }
+}
+
+// Write the normalized bytes of a token; returns the number written
+size_t foldScalar(const char* in, size_t n, char* out) {
+    size_t written = 0;
+    for (size_t i = 0; i < n; ++i) {
+        unsigned char folded = foldByte(static_cast<unsigned char>(in[i]));
+        if (folded) out[written++] = static_cast<char>(folded);
+    }
+    return written;
+}
+
+// Append the bytes selected by keep, in order
+size_t compact(const char* folded, uint32_t keep, char* out) {
+    size_t written = 0;
+    while (keep) {
+        out[written++] = folded[lowestBit(keep)];
+        keep &= keep - 1;
+    }
+    return written;
+}
+
+#ifdef SEARCH_ENGINE_X86
+
+// Signed byte compares: bytes >= 0x80 are negative and fall in no class
+
+SEARCH_ENGINE_TARGET("sse2")
+uint32_t spaceMaskSSE2(__m128i c) {
+    __m128i blank = _mm_cmpeq_epi8(c, _mm_set1_epi8(' '));
+    __m128i control = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('\t' - 1)),
+                                    _mm_cmplt_epi8(c, _mm_set1_epi8('\r' + 1)));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(blank, control)));
+}
+
+SEARCH_ENGINE_TARGET("sse2")
+__m128i lowerAlnumSSE2(__m128i c) {
+    __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)),
+                                  _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+    __m128i lower = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('a' - 1)),
+                                  _mm_cmplt_epi8(c, _mm_set1_epi8('z' + 1)));
+    return _mm_or_si128(digit, lower);
+}
+
+SEARCH_ENGINE_TARGET("sse2")
+void classifySSE2(const char* in, uint64_t& space, uint64_t& clean) {
+    space = 0;
+    clean = 0;
+    for (size_t i = 0; i < kBlockBytes; i += 16) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        space |= static_cast<uint64_t>(spaceMaskSSE2(c)) << i;
+        clean |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(lowerAlnumSSE2(c)))) << i;
+    }
+}
+
+SEARCH_ENGINE_TARGET("sse2")
+size_t foldSSE2(const char* in, size_t n, char* out) {
+    size_t written = 0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('A' - 1)),
+                                      _mm_cmplt_epi8(c, _mm_set1_epi8('Z' + 1)));
+        __m128i folded = _mm_or_si128(c, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+        uint32_t keep = static_cast<uint32_t>(_mm_movemask_epi8(lowerAlnumSSE2(folded)));
+
+        if (keep == 0xFFFF) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + written), folded);
+            written += 16;
+        }
+        else {
+            alignas(16) char bytes[16];
+            _mm_store_si128(reinterpret_cast<__m128i*>(bytes), folded);
+            written += compact(bytes, keep, out + written);
+        }
+    }
+    return written + foldScalar(in + i, n - i, out + written);
+}
+
+SEARCH_ENGINE_TARGET("avx2")
+__m256i lowerAlnumAVX2(__m256i c) {
+    __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('0' - 1)),
+                                     _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), c));
+    __m256i lower = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('a' - 1)),
+                                     _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), c));
+    return _mm256_or_si256(digit, lower);
+}
+
+SEARCH_ENGINE_TARGET("avx2")
+void classifyAVX2(const char* in, uint64_t& space, uint64_t& clean) {
+    space = 0;
+    clean = 0;
+    for (size_t i = 0; i < kBlockBytes; i += 32) {
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        __m256i blank = _mm256_cmpeq_epi8(c, _mm256_set1_epi8(' '));
+        __m256i control = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('\t' - 1)),
+                                           _mm256_cmpgt_epi8(_mm256_set1_epi8('\r' + 1), c));
+        uint32_t space_bits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(blank, control)));
+        uint32_t clean_bits = static_cast<uint32_t>(_mm256_movemask_epi8(lowerAlnumAVX2(c)));
+        space |= static_cast<uint64_t>(space_bits) << i;
+        clean |= static_cast<uint64_t>(clean_bits) << i;
+    }
+}
+
+SEARCH_ENGINE_TARGET("avx2")
+size_t foldAVX2(const char* in, size_t n, char* out) {
+    size_t written = 0;
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('A' - 1)),
+                                         _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), c));
+        __m256i folded = _mm256_or_si256(c, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+        uint32_t keep = static_cast<uint32_t>(_mm256_movemask_epi8(lowerAlnumAVX2(folded)));
+
+        if (keep == 0xFFFFFFFFu) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + written), folded);
+            written += 32;
+        }
+        else {
+            alignas(32) char bytes[32];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(bytes), folded);
+            written += compact(bytes, keep, out + written);
+        }
+    }
+    return written + foldSSE2(in + i, n - i, out + written);
+}
+
+#endif // SEARCH_ENGINE_X86
+
+void classifyBlockScalar(const char* in, uint64_t& space, uint64_t& clean) {
+    classifyScalar(in, kBlockBytes, space, clean);
+}
+
+// Kernels for the best instruction set the CPU supports
+struct Kernels {
+    void (*classify)(const char* in, uint64_t& space, uint64_t& clean) = classifyBlockScalar;
+    size_t (*fold)(const char* in, size_t n, char* out) = foldScalar;
+
+    Kernels() {
+#ifdef SEARCH_ENGINE_X86
+        if (CpuFeatures::hasAVX2()) {
+            classify = classifyAVX2;
+            fold = foldAVX2;
+        }
+        else if (CpuFeatures::hasSSE2()) {
+            classify = classifySSE2;
+            fold = foldSSE2;
+        }
+#endif
+    }
+};
+
+const Kernels& kernels() {
+    static const Kernels selected;
+    return selected;
+}
+
+} // namespace
+
+bool Tokenizer::loadBlock() {
+    // Dirty bytes of an unfinished token in the block being left
+    if (token_start_ != kNoToken) {
+        size_t from = token_start_ > block_start_ ? token_start_ - block_start_ : 0;
+        token_dirty_ = token_dirty_ || (dirty_ >> from) != 0;
+    }
+
+    if (next_block_ >= text_.size()) {
+        return false;
+    }
+
+    block_start_ = next_block_;
+    size_t n = std::min(kBlockBytes, text_.size() - block_start_);
+    next_block_ = block_start_ + n;
+
+    uint64_t clean;
+    if (n == kBlockBytes) {
+        kernels().classify(text_.data() + block_start_, space_, clean);
+    }
+    else {
+        // Treat the bytes past the end as whitespace to close the last token
+        classifyScalar(text_.data() + block_start_, n, space_, clean);
+        space_ |= ~0ull << n;
+    }
+    dirty_ = ~space_ & ~clean;
+
+    // A bit is set wherever a byte's class differs from the one before it
+    transitions_ = space_ ^ ((space_ << 1) | static_cast<uint64_t>(previous_space_));
+    previous_space_ = (space_ >> 63) != 0;
+    return true;
+}
+
+bool Tokenizer::finishToken(size_t end, std::string_view& term) {
+    size_t start = token_start_;
+    token_start_ = kNoToken;
+
+    size_t from = start > block_start_ ? start - block_start_ : 0;
+    size_t to = end - block_start_;
+    uint64_t range = (to < 64 ? (1ull << to) : 0) - (1ull << from);
+    bool dirty = (start < block_start_ && token_dirty_) || (dirty_ & range) != 0;
+
+    if (!dirty) {
+        term = text_.substr(start, end - start);
+        return term.size() <= kMaxTermLength;
+    }
+
+    scratch_.resize(end - start);
+    scratch_.resize(kernels().fold(text_.data() + start, end - start, &scratch_[0]));
+    term = scratch_;
+    return !scratch_.empty() && scratch_.size() <= kMaxTermLength;
+}
+
+bool Tokenizer::next(std::string_view& term) {
+    while (true) {
+        if (transitions_ == 0) {
+            if (loadBlock()) continue;
+
+            // Text ended inside a token, at a block boundary
+            if (token_start_ != kNoToken) {
+                block_start_ = text_.size();
+                dirty_ = 0;
+                if (finishToken(text_.size(), term)) return true;
+            }
+            return false;
+        }
+
+        size_t bit = lowestBit(transitions_);
+        transitions_ &= transitions_ - 1;
+
+        if (((space_ >> bit) & 1) == 0) {
+            token_start_ = block_start_ + bit;
+            token_dirty_ = false;
+        }
+        else if (finishToken(block_start_ + bit, term)) {
+            return true;
+        }
+    }
+}
+
+std::vector<std::string> Tokenizer::tokenize(std::string_view text) {
+    std::vector<std::string> terms;
+    Tokenizer tokenizer(text);
+    std::string_view term;
+    while (tokenizer.next(term)) {
+        terms.emplace_back(term);
+    }
+    return terms;
+}
\ No newline at end of file
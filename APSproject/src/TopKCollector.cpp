@@ -0,0 +1,34 @@
+#include "TopKCollector.hpp"
+#include <algorithm>
+
+void TopKCollector::siftUp(size_t i) {
+    Entry entry = heap_[i];
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!better(heap_[parent], entry)) break;
+        heap_[i] = heap_[parent];
+        i = parent;
+    }
+    heap_[i] = entry;
+}
+
+void TopKCollector::siftDown(size_t i) {
+    const size_t n = heap_.size();
+    Entry entry = heap_[i];
+    while (true) {
+        size_t child = 2 * i + 1;
+        if (child >= n) break;
+        if (child + 1 < n && better(heap_[child], heap_[child + 1])) ++child;
+        if (!better(entry, heap_[child])) break;
+        heap_[i] = heap_[child];
+        i = child;
+    }
+    heap_[i] = entry;
+}
+
+std::vector<TopKCollector::Entry> TopKCollector::takeSorted() {
+    std::vector<Entry> sorted = std::move(heap_);
+    heap_.clear();
+    std::sort(sorted.begin(), sorted.end(), better);
+    return sorted;
+}
\ No newline at end of file
@@ -1,89 +1,291 @@
 #include "Trie.hpp"
 #include <algorithm>
 #include <queue>
+#include <stdexcept>
 
-void Trie::insert(const std::string& word) {
-    auto current = root_;
-    for (char c : word) {
-        if (!current->children[c]) {
-            current->children[c] = std::make_shared<Node>();
+namespace {
+
+// Child runs up to this length are scanned linearly, longer ones searched
+constexpr size_t kLinearScanLimit = 16;
+
+} // namespace
+
+Trie::Trie(size_t max_suggestions) : nodes_(1), subtree_max_(1), max_suggestions_(max_suggestions) {}
+
+uint32_t Trie::findChild(uint32_t node, unsigned char c) const {
+    const Node& n = nodes_[node];
+    const unsigned char* first = labels_.data() + n.edges;
+    const unsigned char* last = first + n.num_children;
+    
+    const unsigned char* it = first;
+    if (n.num_children <= kLinearScanLimit) {
+        while (it != last && *it < c) ++it;
+    }
+    else {
+        it = std::lower_bound(first, last, c);
+    }
+    return it != last && *it == c ? children_[n.edges + (it - first)] : kNone;
+}
+
+uint32_t Trie::allocateRun(uint8_t slot_class) {
+    auto& free_runs = free_runs_[slot_class];
+    if (!free_runs.empty()) {
+        uint32_t run = free_runs.back();
+        free_runs.pop_back();
+        return run;
+    }
+    
+    size_t run = labels_.size();
+    size_t slots = size_t{1} << slot_class;
+    if (run + slots > kNone) {
+        throw std::runtime_error("Trie is full");
+    }
+    labels_.resize(run + slots);
+    children_.resize(run + slots);
+    return static_cast<uint32_t>(run);
+}
+
+uint32_t Trie::addChild(uint32_t node, unsigned char c) {
+    if (nodes_.size() >= kNone) {
+        throw std::runtime_error("Trie is full");
+    }
+    uint32_t child = static_cast<uint32_t>(nodes_.size());
+    nodes_.emplace_back();
+    subtree_max_.push_back(0);
+    
+    // Move a full run into one twice the size; the old run is reused later
+    Node& n = nodes_[node];
+    if (n.num_children == 0 || n.num_children == (size_t{1} << n.slot_class)) {
+        uint8_t slot_class = n.num_children == 0 ? 0 : n.slot_class + 1;
+        uint32_t run = allocateRun(slot_class);
+        if (n.num_children > 0) {
+            std::copy_n(labels_.begin() + n.edges, n.num_children, labels_.begin() + run);
+            std::copy_n(children_.begin() + n.edges, n.num_children, children_.begin() + run);
+            free_runs_[n.slot_class].push_back(n.edges);
         }
-        current = current->children[c];
+        n.edges = run;
+        n.slot_class = slot_class;
     }
-    current->is_end = true;
-    current->frequency++;
+    
+    // Keep the run sorted by label
+    auto first = labels_.begin() + n.edges;
+    size_t position = std::lower_bound(first, first + n.num_children, c) - first;
+    std::copy_backward(first + position, first + n.num_children, first + n.num_children + 1);
+    auto targets = children_.begin() + n.edges;
+    std::copy_backward(targets + position, targets + n.num_children, targets + n.num_children + 1);
+    first[position] = c;
+    targets[position] = child;
+    ++n.num_children;
+    return child;
 }
 
-bool Trie::contains(const std::string& word) const {
-    auto current = root_;
+uint32_t Trie::find(const std::string& word) const {
+    uint32_t current = 0;
     for (char c : word) {
-        auto it = current->children.find(c);
-        if (it == current->children.end()) {
-            return false;
-        }
-        current = it->second;
+        current = findChild(current, static_cast<unsigned char>(c));
+        if (current == kNone) return kNone;
     }
-    return current->is_end;
+    return current;
 }
 
-void Trie::incrementFrequency(const std::string& word) {
-    auto current = root_;
+void Trie::insert(const std::string& word, size_t count) {
+    uint32_t current = 0;
     for (char c : word) {
-        auto it = current->children.find(c);
-        if (it == current->children.end()) {
-            return;
-        }
-        current = it->second;
+        uint32_t child = findChild(current, static_cast<unsigned char>(c));
+        current = child != kNone ? child : addChild(current, static_cast<unsigned char>(c));
     }
-    if (current->is_end) {
-        current->frequency++;
+    
+    Node& node = nodes_[current];
+    if (node.word == kNone) {
+        node.word = static_cast<uint32_t>(frequencies_.size());
+        frequencies_.push_back(0);
+        popularity_.push_back(0);
+    }
+    frequencies_[node.word] += count;
+    raiseSubtreeMax(word, weight(node.word));
+}
+
+void Trie::raiseSubtreeMax(const std::string& word, size_t weight) {
+    uint32_t current = 0;
+    for (size_t i = 0;; ++i) {
+        subtree_max_[current] = std::max(subtree_max_[current], weight);
+        if (i == word.size()) break;
+        current = findChild(current, static_cast<unsigned char>(word[i]));
     }
 }
 
-void Trie::findAllWords(const std::shared_ptr<Node>& node, const std::string& prefix,
-                       std::vector<std::pair<std::string, size_t>>& result) const {
-    if (!node) return;
+void Trie::recomputeSubtreeMax(const std::string& word) {
+    std::vector<uint32_t> path(1, 0);
+    for (char c : word) {
+        path.push_back(findChild(path.back(), static_cast<unsigned char>(c)));
+    }
     
-    if (node->is_end) {
-        result.emplace_back(prefix, node->frequency);
+    for (auto it = path.rbegin(); it != path.rend(); ++it) {
+        const Node& n = nodes_[*it];
+        size_t best = n.word != kNone ? weight(n.word) : 0;
+        for (size_t i = 0; i < n.num_children; ++i) {
+            best = std::max(best, subtree_max_[children_[n.edges + i]]);
+        }
+        subtree_max_[*it] = best;
     }
+}
+
+bool Trie::contains(const std::string& word) const {
+    uint32_t node = find(word);
+    return node != kNone && nodes_[node].word != kNone;
+}
+
+void Trie::setPopularity(const std::string& word, size_t popularity) {
+    uint32_t node = find(word);
+    if (node == kNone || nodes_[node].word == kNone) return;
     
-    for (const auto& [c, child] : node->children) {
-        findAllWords(child, prefix + c, result);
+    size_t& current = popularity_[nodes_[node].word];
+    bool lowered = popularity < current;
+    current = popularity;
+    if (lowered) {
+        recomputeSubtreeMax(word);
+    }
+    else {
+        raiseSubtreeMax(word, weight(nodes_[node].word));
     }
 }
 
-std::vector<std::string> Trie::getSuggestions(const std::string& prefix) const {
-    auto current = root_;
+void Trie::findAllWords(uint32_t node, std::string& word,
+                        std::vector<std::pair<std::string, size_t>>& result) const {
+    const Node& n = nodes_[node];
+    if (n.word != kNone) {
+        result.emplace_back(word, frequencies_[n.word]);
+    }
     
+    for (size_t i = 0; i < n.num_children; ++i) {
+        word.push_back(static_cast<char>(labels_[n.edges + i]));
+        findAllWords(children_[n.edges + i], word, result);
+        word.pop_back();
+    }
+}
+
+std::vector<std::string> Trie::getSuggestions(const std::string& prefix) const {
     // Find the node corresponding to the prefix
-    for (char c : prefix) {
-        auto it = current->children.find(c);
-        if (it == current->children.end()) {
-            return {};
-        }
-        current = it->second;
+    uint32_t node = find(prefix);
+    if (node == kNone) {
+        return {};
     }
+    return complete(node, prefix, nullptr);
+}
+
+std::vector<std::string> Trie::getFuzzySuggestions(const std::string& prefix, size_t max_distance) const {
+    LevenshteinAutomaton automaton(prefix, max_distance);
+    return complete(0, "", &automaton);
+}
+
+std::vector<std::string> Trie::complete(uint32_t node, const std::string& path,
+                                        const LevenshteinAutomaton* automaton) const {
+    // Best-first search: closest first, then heaviest, then alphabetically.
+    // A subtree is queued with its maximum weight, which no word below it
+    // exceeds, and its path, which sorts before every word below it; so a
+    // word leaves the queue only once nothing queued can precede it.
+    auto later = [](const Completion& a, const Completion& b) {
+        if (a.distance != b.distance) return a.distance > b.distance;
+        return a.weight != b.weight ? a.weight < b.weight : a.path > b.path;
+    };
+    std::priority_queue<Completion, std::vector<Completion>, decltype(later)> queue(later);
     
-    // Find all words with this prefix
-    std::vector<std::pair<std::string, size_t>> words;
-    findAllWords(current, prefix, words);
-    
-    // Sort by frequency
-    std::sort(words.begin(), words.end(),
-              [](const auto& a, const auto& b) { return a.second > b.second; });
+    // With an automaton, best is the smallest distance from the prefix to a
+    // prefix of the path. Once no extension can lower it, the subtree is
+    // settled at that distance; until then it is queued at the lowest
+    // distance an extension could reach, with its automaton state kept in
+    // rows, and branches past the maximum distance are dropped.
+    std::vector<LevenshteinAutomaton::State> rows;
+    LevenshteinAutomaton::State next;
+    auto enqueue = [&](uint32_t child, std::string child_path, size_t best) {
+        best = std::min(best, automaton->distance(next));
+        size_t lowest = automaton->lowestDistance(next);
+        if (lowest >= best) {
+            if (best <= automaton->getMaxDistance()) {
+                queue.push({best, subtree_max_[child], child, std::move(child_path), best, kNone});
+            }
+        } else {
+            queue.push({lowest, subtree_max_[child], child, std::move(child_path), best,
+                        static_cast<uint32_t>(rows.size())});
+            rows.push_back(next);
+        }
+    };
+    if (automaton) {
+        next = automaton->start();
+        enqueue(node, path, automaton->getMaxDistance() + 1);
+    } else {
+        queue.push({0, subtree_max_[node], node, path, 0, kNone});
+    }
     
-    // Extract top suggestions
     std::vector<std::string> suggestions;
-    suggestions.reserve(std::min(words.size(), max_suggestions_));
-    
-    for (size_t i = 0; i < words.size() && i < max_suggestions_; ++i) {
-        suggestions.push_back(words[i].first);
+    while (!queue.empty() && suggestions.size() < max_suggestions_) {
+        Completion candidate = queue.top();
+        queue.pop();
+        if (candidate.node == kNone) {
+            suggestions.push_back(std::move(candidate.path));
+            continue;
+        }
+        
+        const Node& n = nodes_[candidate.node];
+        bool settled = candidate.row == kNone;
+        if (n.word != kNone && (settled || candidate.best <= automaton->getMaxDistance())) {
+            queue.push({candidate.best, weight(n.word), kNone, candidate.path, candidate.best, kNone});
+        }
+        for (size_t i = 0; i < n.num_children; ++i) {
+            uint32_t child = children_[n.edges + i];
+            unsigned char label = labels_[n.edges + i];
+            if (settled) {
+                queue.push({candidate.distance, subtree_max_[child], child,
+                            candidate.path + static_cast<char>(label), candidate.best, kNone});
+            } else {
+                automaton->step(rows[candidate.row], label, next);
+                enqueue(child, candidate.path + static_cast<char>(label), candidate.best);
+            }
+        }
     }
     
     return suggestions;
 }
 
+size_t Trie::memoryUsage() const {
+    size_t usage = nodes_.capacity() * sizeof(Node) + labels_.capacity() + children_.capacity() * sizeof(uint32_t) +
+                   (frequencies_.capacity() + popularity_.capacity() + subtree_max_.capacity()) * sizeof(size_t);
+    for (const auto& free_runs : free_runs_) {
+        usage += free_runs.capacity() * sizeof(uint32_t);
+    }
+    return usage;
+}
+
+void Trie::serialize(BinaryWriter& writer) const {
+    std::vector<std::pair<std::string, size_t>> words;
+    std::string path;
+    findAllWords(0, path, words);
+    
+    writer.write(static_cast<uint64_t>(words.size()));
+    for (const auto& [word, frequency] : words) {
+        writer.writeString(word);
+        writer.write(static_cast<uint64_t>(frequency));
+    }
+}
+
+void Trie::deserialize(BinaryReader& reader) {
+    clear();
+    uint64_t count = reader.read<uint64_t>();
+    for (uint64_t i = 0; i < count; ++i) {
+        std::string word(reader.readString());
+        insert(word, static_cast<size_t>(reader.read<uint64_t>()));
+    }
+}
+
 void Trie::clear() {
-    root_ = std::make_shared<Node>();
-} 
\ No newline at end of file
+    // Swap with empty containers to release the arena
+    std::vector<Node>(1).swap(nodes_);
+    std::vector<unsigned char>().swap(labels_);
+    std::vector<uint32_t>().swap(children_);
+    for (auto& free_runs : free_runs_) {
+        std::vector<uint32_t>().swap(free_runs);
+    }
+    std::vector<size_t>().swap(frequencies_);
+    std::vector<size_t>().swap(popularity_);
+    std::vector<size_t>(1).swap(subtree_max_);
+}
\ No newline at end of file
@@ -81,6 +81,10 @@ int main() {
             std::string prefix = command.substr(9);
             try {
                 auto suggestions = engine.getAutocompleteSuggestions(prefix);
+                if (suggestions.empty()) {
+                    // Maybe the prefix has a typo
+                    suggestions = engine.getFuzzyAutocompleteSuggestions(prefix);
+                }
                 if (suggestions.empty()) {
                     std::cout << "No suggestions found.\n";
                 }
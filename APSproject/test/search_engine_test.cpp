@@ -1,9 +1,27 @@
 #include <gtest/gtest.h>
 #include "SearchEngine.hpp"
+#include "MappedFile.hpp"
+#include "Tokenizer.hpp"
+#include "HuffmanCompression.hpp"
+#include "CompressedFile.hpp"
+#include "RansCompression.hpp"
+#include "Intersection.hpp"
+#include "Trie.hpp"
+#include "QueryLog.hpp"
+#include "TermDictionary.hpp"
 #include <fstream>
 #include <sstream>
 #include <chrono>
 #include <thread>
+#include <cmath>
+#include <random>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <cstring>
+#include <tuple>
 
 class SearchEngineTest : public ::testing::Test {
 protected:
@@ -65,11 +83,52 @@ TEST_F(SearchEngineTest, DuplicateDocumentId) {
     EXPECT_THROW(engine.addDocument("doc1", "test_doc2.txt"), std::exception);
 }
 
+TEST_F(SearchEngineTest, BulkAddMatchesSequentialAdd) {
+    SearchEngine bulk(3);
+    bulk.addDocuments({{"doc1", "test_doc1.txt"}, {"doc2", "test_doc2.txt"},
+                       {"doc3", "test_doc3.txt"}, {"large", "large_doc.txt"}});
+    engine.addDocument("doc1", "test_doc1.txt");
+    engine.addDocument("doc2", "test_doc2.txt");
+    engine.addDocument("doc3", "test_doc3.txt");
+    engine.addDocument("large", "large_doc.txt");
+    
+    EXPECT_EQ(bulk.getDocumentCount(), 4);
+    for (const char* query : {"machine learning", "language", "neural networks line"}) {
+        auto expected = engine.search(query);
+        auto actual = bulk.search(query);
+        ASSERT_EQ(actual.size(), expected.size());
+        for (size_t i = 0; i < actual.size(); i++) {
+            EXPECT_EQ(actual[i].first, expected[i].first);
+            EXPECT_DOUBLE_EQ(actual[i].second, expected[i].second);
+        }
+    }
+    // Suggestions with equal frequency have no defined order
+    auto bulk_suggestions = bulk.getAutocompleteSuggestions("l");
+    auto suggestions = engine.getAutocompleteSuggestions("l");
+    std::sort(bulk_suggestions.begin(), bulk_suggestions.end());
+    std::sort(suggestions.begin(), suggestions.end());
+    EXPECT_EQ(bulk_suggestions, suggestions);
+    EXPECT_EQ(bulk.getSpellingSuggestions("neurall"), engine.getSpellingSuggestions("neurall"));
+}
+
+TEST_F(SearchEngineTest, BulkAddIsAllOrNothing) {
+    engine.addDocument("doc1", "test_doc1.txt");
+    EXPECT_THROW(engine.addDocuments({{"doc2", "test_doc2.txt"}, {"doc1", "test_doc3.txt"}}),
+                 std::invalid_argument);
+    EXPECT_THROW(engine.addDocuments({{"doc2", "test_doc2.txt"}, {"doc3", "nonexistent.txt"}}),
+                 std::runtime_error);
+    EXPECT_EQ(engine.getDocumentCount(), 1);
+    EXPECT_TRUE(engine.search("neural").empty());
+}
+
 // Search Functionality Tests
 TEST_F(SearchEngineTest, BasicSearch) {
+    // A term found in every document has an IDF of 0, so the query terms
+    // need documents without them to score
     engine.addDocument("doc1", "test_doc1.txt");
+    engine.addDocument("doc3", "test_doc3.txt");
     auto results = engine.search("machine learning");
-    EXPECT_FALSE(results.empty());
+    ASSERT_FALSE(results.empty());
     EXPECT_EQ(results[0].first, "doc1");
 }
 
@@ -77,7 +136,7 @@ TEST_F(SearchEngineTest, MultiDocumentSearch) {
     engine.addDocument("doc1", "test_doc1.txt");
     engine.addDocument("doc2", "test_doc2.txt");
     auto results = engine.search("neural networks");
-    EXPECT_FALSE(results.empty());
+    ASSERT_FALSE(results.empty());
     EXPECT_EQ(results[0].first, "doc2");
 }
 
@@ -86,10 +145,250 @@ TEST_F(SearchEngineTest, SearchRelevanceOrder) {
     engine.addDocument("doc2", "test_doc2.txt");
     engine.addDocument("doc3", "test_doc3.txt");
     
-    auto results = engine.search("artificial intelligence");
-    EXPECT_GE(results.size(), 2);
+    // Only doc1 mentions "artificial intelligence"; doc2 shares "learning"
+    auto results = engine.search("machine learning");
+    ASSERT_GE(results.size(), 2u);
     // Doc1 should be more relevant as it contains both terms
     EXPECT_EQ(results[0].first, "doc1");
+    EXPECT_EQ(results[1].first, "doc2");
+}
+
+TEST_F(SearchEngineTest, PostingDrivenScores) {
+    engine.addDocument("doc1", "test_doc1.txt");
+    engine.addDocument("doc2", "test_doc2.txt");
+    engine.addDocument("doc3", "test_doc3.txt");
+    
+    // Scores from a previous query must not leak into the next one
+    engine.search("neural networks");
+    auto results = engine.search("language");
+    ASSERT_EQ(results.size(), 1);
+    EXPECT_EQ(results[0].first, "doc3");
+    // "language" occurs twice in doc3 and in one of three documents
+    EXPECT_NEAR(results[0].second, (1.0 + std::log(2.0)) * std::log(3.0), 1e-9);
+}
+
+TEST(InvertedIndexTest, DenseIdentifiers) {
+    std::ofstream("dense_a.txt") << "apple banana apple";
+    std::ofstream("dense_b.txt") << "banana cherry";
+    auto a = std::make_shared<Document>("a", "dense_a.txt");
+    auto b = std::make_shared<Document>("b", "dense_b.txt");
+    ASSERT_TRUE(a->parse());
+    ASSERT_TRUE(b->parse());
+    
+    InvertedIndex index;
+    EXPECT_EQ(index.addDocument(a), 0u);
+    EXPECT_EQ(index.addDocument(b), 1u);
+    EXPECT_EQ(index.getDocument(1).path, "dense_b.txt");
+    EXPECT_EQ(index.getTermCount(), 3u);
+    
+    uint32_t banana = index.getTermId("banana");
+    ASSERT_NE(banana, InvertedIndex::kInvalidId);
+    EXPECT_EQ(index.getTerm(banana), "banana");
+    ASSERT_EQ(index.getPostings(banana).size(), 2u);
+    EXPECT_EQ(index.getPostings(banana).decode()[1].doc_id, 1u);
+    EXPECT_EQ(index.getPostings("apple").decode()[0].term_frequency, 2u);
+    EXPECT_EQ(index.getTermId("durian"), InvertedIndex::kInvalidId);
+    EXPECT_THROW(index.addDocument(a), std::invalid_argument);
+    
+    std::remove("dense_a.txt");
+    std::remove("dense_b.txt");
+}
+
+TEST_F(SearchEngineTest, BlockMaxWandMatchesExhaustive) {
+    // Skewed vocabulary so common terms span many posting blocks
+    std::mt19937 rng(42);
+    std::vector<std::string> vocabulary;
+    for (int i = 0; i < 40; i++) vocabulary.push_back("term" + std::to_string(i));
+    std::geometric_distribution<int> pick(0.12);
+    std::uniform_int_distribution<int> length(1, 30);
+    
+    for (int d = 0; d < 300; d++) {
+        std::string name = "bmw_doc" + std::to_string(d) + ".txt";
+        std::ofstream file(name);
+        for (int w = length(rng); w > 0; w--) {
+            file << vocabulary[std::min<int>(pick(rng), vocabulary.size() - 1)] << " ";
+        }
+        file.close();
+        engine.addDocument(name, name);
+        std::remove(name.c_str());
+    }
+    
+    std::uniform_int_distribution<int> any_term(0, vocabulary.size() - 1);
+    for (int q = 0; q < 50; q++) {
+        std::string query;
+        for (int t = q % 4; t >= 0; t--) query += vocabulary[any_term(rng) / (t + 1)] + " ";
+        size_t k = 1 + q % 10;
+        engine.setImpactScoring(q % 2 == 1);
+        
+        engine.setScoringStrategy(SearchEngine::ScoringStrategy::TermAtATime);
+        auto expected = engine.search(query, k);
+        engine.setScoringStrategy(SearchEngine::ScoringStrategy::BlockMaxWand);
+        auto actual = engine.search(query, k);
+        
+        ASSERT_EQ(actual.size(), expected.size()) << query;
+        for (size_t i = 0; i < actual.size(); i++) {
+            EXPECT_EQ(actual[i].first, expected[i].first) << query;
+            EXPECT_NEAR(actual[i].second, expected[i].second, 1e-9) << query;
+        }
+    }
+}
+
+TEST_F(SearchEngineTest, SearchIteratorYieldsRankedResults) {
+    engine.addDocument("doc1", "test_doc1.txt");
+    engine.addDocument("doc2", "test_doc2.txt");
+    engine.addDocument("doc3", "test_doc3.txt");
+    
+    auto expected = engine.search("learning language networks artificial", 10);
+    auto it = engine.searchIterator("learning language networks artificial");
+    for (const auto& result : expected) {
+        ASSERT_TRUE(it.hasNext());
+        auto pulled = it.next();
+        EXPECT_EQ(pulled.first, result.first);
+        EXPECT_DOUBLE_EQ(pulled.second, result.second);
+    }
+    EXPECT_FALSE(it.hasNext());
+    EXPECT_THROW(it.next(), std::out_of_range);
+    
+    // Enough matches to span several batches, with tied scores
+    for (int i = 0; i < 100; i++) {
+        std::string path = "iterator_doc" + std::to_string(i) + ".txt";
+        std::string text = "networks";
+        for (int j = 0; j < i % 7; j++) text += " networks";
+        createTestFile(path, text);
+        engine.addDocument("it" + std::to_string(i), path);
+        std::remove(path.c_str());
+    }
+    for (auto strategy : {SearchEngine::ScoringStrategy::TermAtATime, SearchEngine::ScoringStrategy::BlockMaxWand}) {
+        engine.setScoringStrategy(strategy);
+        expected = engine.search("networks language", SIZE_MAX);
+        ASSERT_EQ(expected.size(), 102u);
+        auto all = engine.searchIterator("networks language");
+        std::vector<std::pair<std::string, double>> pulled;
+        while (all.hasNext()) pulled.push_back(all.next());
+        EXPECT_EQ(pulled, expected);
+    }
+    
+    // Boolean matches are scored once and handed out across batches
+    expected = engine.search("networks AND NOT language", SIZE_MAX);
+    ASSERT_EQ(expected.size(), 101u);
+    auto boolean = engine.searchIterator("networks AND NOT language");
+    std::vector<std::pair<std::string, double>> pulled;
+    while (boolean.hasNext()) pulled.push_back(boolean.next());
+    EXPECT_EQ(pulled, expected);
+}
+
+TEST(TopKCollectorTest, KeepsBestEntries) {
+    TopKCollector top_k(3);
+    double scores[] = {0.5, 2.0, 0.0, 1.0, 3.0, 1.0, 0.25};
+    for (uint32_t doc = 0; doc < 7; doc++) top_k.offer(doc, scores[doc]);
+    
+    auto best = top_k.takeSorted();
+    ASSERT_EQ(best.size(), 3u);
+    EXPECT_EQ(best[0].first, 4u);
+    EXPECT_EQ(best[1].first, 1u);
+    EXPECT_EQ(best[2].first, 3u);  // Ties keep the smaller document ID
+}
+
+TEST_F(SearchEngineTest, UnboundedResultCount) {
+    engine.addDocument("doc1", "test_doc1.txt");
+    engine.addDocument("doc2", "test_doc2.txt");
+    engine.addDocument("doc3", "test_doc3.txt");
+    
+    // A limit beyond any collection returns every match, for every strategy
+    for (auto strategy : {SearchEngine::ScoringStrategy::TermAtATime, SearchEngine::ScoringStrategy::BlockMaxWand}) {
+        engine.setScoringStrategy(strategy);
+        EXPECT_EQ(engine.search("machine learning", SIZE_MAX).size(), 2u);
+        EXPECT_EQ(engine.search("learning AND NOT neural", SIZE_MAX).size(), 1u);
+    }
+}
+
+TEST_F(SearchEngineTest, ImpactScoringApproximatesExact) {
+    engine.addDocument("doc1", "test_doc1.txt");
+    engine.addDocument("doc2", "test_doc2.txt");
+    engine.addDocument("doc3", "test_doc3.txt");
+    engine.addDocument("large", "large_doc.txt");
+    
+    auto exact = engine.search("machine language networks test");
+    engine.setImpactScoring(true);
+    auto quantized = engine.search("machine language networks test");
+    
+    ASSERT_EQ(quantized.size(), exact.size());
+    for (size_t i = 0; i < exact.size(); i++) {
+        EXPECT_EQ(quantized[i].first, exact[i].first);
+        EXPECT_NEAR(quantized[i].second, exact[i].second, 0.03 * exact[i].second);
+    }
+}
+
+TEST_F(SearchEngineTest, ImpactScoringIgnoresFlushes) {
+    // Reference: every posting quantized while buffered
+    SearchEngine buffered;
+    buffered.setImpactScoring(true);
+    for (auto* engine_ptr : {&buffered, &engine}) {
+        engine_ptr->addDocument("doc1", "test_doc1.txt");
+        engine_ptr->addDocument("doc2", "test_doc2.txt");
+    }
+    
+    // doc1 and doc2 are flushed without impacts, doc3 and large buffered
+    // with them, and both parts must score like the reference
+    engine.flush();
+    engine.setImpactScoring(true);
+    for (auto* engine_ptr : {&buffered, &engine}) {
+        engine_ptr->addDocument("doc3", "test_doc3.txt");
+        engine_ptr->addDocument("large", "large_doc.txt");
+    }
+    
+    auto expect_same = [&buffered](const SearchEngine& actual_engine) {
+        for (const char* query : {"machine language networks test", "learning AND NOT language"}) {
+            auto expected = buffered.search(query);
+            auto actual = actual_engine.search(query);
+            ASSERT_EQ(actual.size(), expected.size()) << query;
+            for (size_t i = 0; i < actual.size(); i++) {
+                EXPECT_EQ(actual[i].first, expected[i].first) << query;
+                EXPECT_NEAR(actual[i].second, expected[i].second, 1e-9) << query;
+            }
+        }
+    };
+    for (auto strategy : {SearchEngine::ScoringStrategy::TermAtATime, SearchEngine::ScoringStrategy::BlockMaxWand}) {
+        buffered.setScoringStrategy(strategy);
+        engine.setScoringStrategy(strategy);
+        expect_same(engine);
+        engine.flush();
+        expect_same(engine);
+    }
+}
+
+TEST(PostingListTest, CompressedRoundTripAndSkipping) {
+    // Gaps and frequencies spanning 1- to 4-byte encodings, several full
+    // blocks plus an uncompressed tail
+    std::mt19937 rng(7);
+    std::vector<PostingList::Posting> expected;
+    PostingList list;
+    uint32_t doc = 0;
+    for (int i = 0; i < 1000; i++) {
+        uint32_t gap = 1 + (rng() >> (8 * (i % 4) + rng() % 8));
+        uint32_t tf = 1 + (rng() >> (8 * ((i / 3) % 4)));
+        doc += gap % (1u << 22);
+        if (!expected.empty() && doc == expected.back().doc_id) doc++;
+        expected.push_back({doc, tf});
+        list.append(expected.back());
+    }
+    
+    auto decoded = list.decode();
+    ASSERT_EQ(decoded.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        EXPECT_EQ(decoded[i].doc_id, expected[i].doc_id);
+        EXPECT_EQ(decoded[i].term_frequency, expected[i].term_frequency);
+    }
+    EXPECT_LT(list.memoryUsage(), expected.size() * sizeof(PostingList::Posting));
+    
+    PostingCursor cursor(list.view());
+    for (size_t i = 0; i < expected.size(); i += 37) {
+        cursor.nextGEQ(expected[i].doc_id);
+        ASSERT_EQ(cursor.docId(), expected[i].doc_id);
+        EXPECT_EQ(cursor.termFrequency(), expected[i].term_frequency);
+    }
+    cursor.nextGEQ(expected.back().doc_id + 1);
+    EXPECT_EQ(cursor.docId(), PostingCursor::kEnd);
 }
 
 // Autocomplete Tests
@@ -127,6 +426,7 @@ TEST_F(SearchEngineTest, SpellCheckMultipleSuggestions) {
 // Performance Tests
 TEST_F(SearchEngineTest, LargeDocumentHandling) {
     EXPECT_NO_THROW(engine.addDocument("large", "large_doc.txt"));
+    engine.addDocument("doc3", "test_doc3.txt");
     auto start = std::chrono::high_resolution_clock::now();
     auto results = engine.search("machine learning");
     auto end = std::chrono::high_resolution_clock::now();
@@ -192,4 +492,1234 @@ TEST_F(SearchEngineTest, ConcurrentSearches) {
     
     t1.join();
     t2.join();
-} 
\ No newline at end of file
+}
+
+TEST_F(SearchEngineTest, SearchesDuringIngestion) {
+    engine.addDocument("doc1", "test_doc1.txt");
+    engine.addDocument("doc2", "test_doc2.txt");
+    auto pinned = engine.searchIterator("machine learning");
+    
+    std::atomic<bool> ingesting{true};
+    std::thread writer([&]() {
+        for (int i = 0; i < 200; i++) {
+            engine.addDocument("ingest" + std::to_string(i), "test_doc3.txt");
+        }
+        ingesting = false;
+    });
+    
+    auto search_func = [&]() {
+        size_t last_count = 0;
+        while (ingesting) {
+            auto results = engine.search("machine learning");
+            ASSERT_FALSE(results.empty());
+            EXPECT_EQ(results[0].first, "doc1");
+            
+            size_t count = engine.getDocumentCount();
+            EXPECT_GE(count, last_count);
+            last_count = count;
+        }
+    };
+    
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; t++) readers.emplace_back(search_func);
+    writer.join();
+    for (auto& reader : readers) reader.join();
+    
+    EXPECT_EQ(engine.getDocumentCount(), 202);
+    
+    // The iterator still reads the snapshot it was created from
+    ASSERT_TRUE(pinned.hasNext());
+    EXPECT_EQ(pinned.next().first, "doc1");
+    EXPECT_FALSE(pinned.hasNext());
+}
+
+TEST(EpochManagerTest, DefersReclamationWhilePinned) {
+    EpochManager epochs;
+    int freed = 0;
+    
+    {
+        EpochManager::Guard guard(epochs);
+        epochs.retire([&freed]() { freed++; });
+        EXPECT_EQ(epochs.reclaim(), 0);
+        EXPECT_EQ(epochs.pendingCount(), 1);
+        
+        // Moving a pin keeps it in force
+        EpochManager::Guard moved(std::move(guard));
+        EXPECT_EQ(epochs.reclaim(), 0);
+    }
+    
+    // Readers that pin after a retirement do not hold it back
+    EpochManager::Guard later(epochs);
+    EXPECT_EQ(epochs.reclaim(), 1);
+    EXPECT_EQ(freed, 1);
+    EXPECT_EQ(epochs.pendingCount(), 0);
+}
+
+TEST_F(SearchEngineTest, MappedParseNormalizesWords) {
+    createTestFile("mapped_doc.txt", "  Hello,\tWORLD!\r\nhello world-wide 42 ... \v\f(hello)");
+    Document doc("mapped", "mapped_doc.txt");
+    ASSERT_TRUE(doc.parse());
+    
+    const auto& occurrences = doc.getWordOccurrences();
+    EXPECT_EQ(occurrences.size(), 4);
+    EXPECT_EQ(occurrences.at("hello").frequency, 3);
+    EXPECT_EQ(occurrences.at("world").frequency, 1);
+    EXPECT_EQ(occurrences.at("worldwide").frequency, 1);
+    EXPECT_EQ(occurrences.at("42").frequency, 1);
+    EXPECT_EQ(occurrences.at("hello").positions, (std::vector<uint32_t>{0, 2, 5}));
+    EXPECT_EQ(doc.getWordCount(), 6);
+    
+    // Without positions only the frequencies are kept
+    Document counted("counted", "mapped_doc.txt");
+    ASSERT_TRUE(counted.parse(false));
+    EXPECT_EQ(counted.getWordOccurrences().at("hello").frequency, 3);
+    EXPECT_TRUE(counted.getWordOccurrences().at("hello").positions.empty());
+    InvertedIndex positional;
+    positional.setStorePositions(true);
+    EXPECT_THROW(positional.addDocument(std::make_shared<Document>(counted)), std::invalid_argument);
+    
+    // Copies own their words
+    Document copy = doc;
+    std::remove("mapped_doc.txt");
+    EXPECT_EQ(copy.getWordOccurrences().at("hello").frequency, 3);
+    
+    MappedFile missing;
+    EXPECT_FALSE(missing.open("mapped_doc.txt"));
+    EXPECT_FALSE(missing.isOpen());
+}
+
+TEST(TokenizerTest, MatchesScalarReference) {
+    // Byte-at-a-time reference: split on ASCII whitespace, keep lowercased
+    // letters and digits
+    auto reference = [](const std::string& text) {
+        std::vector<std::string> terms;
+        std::string term;
+        for (size_t i = 0; i <= text.size(); i++) {
+            unsigned char c = i < text.size() ? text[i] : ' ';
+            if (c == ' ' || (c >= '\t' && c <= '\r')) {
+                if (!term.empty() && term.size() <= Tokenizer::kMaxTermLength) terms.push_back(term);
+                term.clear();
+            }
+            else if (c >= 'A' && c <= 'Z') term += static_cast<char>(c + 32);
+            else if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')) term += static_cast<char>(c);
+        }
+        return terms;
+    };
+    
+    // Mostly clean words with long runs, so tokens cross 64-byte blocks
+    const std::string alphabet = "abcdefghijklmnopqrstuvwxyz0123456789ABCXYZ  \t\n\r\v\f.,-!@[`{\x80\xff";
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<size_t> pick(0, alphabet.size() - 1);
+    std::uniform_int_distribution<int> clean_run(0, 3);
+    for (size_t length = 0; length < 400; length += 1 + length / 8) {
+        std::string text;
+        while (text.size() < length) {
+            char c = alphabet[pick(rng)];
+            text.append(clean_run(rng) == 0 ? 40 : 1, c);
+        }
+        text.resize(length);
+        EXPECT_EQ(Tokenizer::tokenize(text), reference(text)) << "length " << length;
+    }
+    
+    // Text ending inside a token exactly at a block boundary
+    for (size_t length : {64, 128, 192}) {
+        std::string clean(length, 'a');
+        std::string dirty = "x" + std::string(length - 2, 'B') + "!";
+        EXPECT_EQ(Tokenizer::tokenize(clean), reference(clean));
+        EXPECT_EQ(Tokenizer::tokenize(dirty), reference(dirty));
+    }
+    
+    EXPECT_EQ(Tokenizer::tokenize("Hello, WORLD! machine-learning"),
+              (std::vector<std::string>{"hello", "world", "machinelearning"}));
+    
+    // Overlong terms are dropped, whether clean or folded
+    std::string longest(Tokenizer::kMaxTermLength, 'a');
+    EXPECT_EQ(Tokenizer::tokenize("x " + longest + " " + longest + "a " + longest + "A! y"),
+              (std::vector<std::string>{"x", longest, "y"}));
+}
+
+TEST_F(SearchEngineTest, LoadIndexWithoutSourceDocuments) {
+    engine.addDocument("doc1", "test_doc1.txt");
+    engine.addDocument("doc2", "test_doc2.txt");
+    engine.addDocument("doc3", "test_doc3.txt");
+    engine.search("language");
+    ASSERT_TRUE(engine.saveIndex("test_index.bin"));
+    
+    // Loading must not touch the source files
+    std::remove("test_doc1.txt");
+    std::remove("test_doc2.txt");
+    std::remove("test_doc3.txt");
+    
+    SearchEngine loaded;
+    ASSERT_TRUE(loaded.loadIndex("test_index.bin"));
+    EXPECT_EQ(loaded.getDocumentCount(), 3);
+    for (const char* query : {"machine learning", "language", "neural networks"}) {
+        auto expected = engine.search(query);
+        auto actual = loaded.search(query);
+        ASSERT_EQ(actual.size(), expected.size());
+        for (size_t i = 0; i < actual.size(); i++) {
+            EXPECT_EQ(actual[i].first, expected[i].first);
+            EXPECT_DOUBLE_EQ(actual[i].second, expected[i].second);
+        }
+    }
+    EXPECT_EQ(loaded.getAutocompleteSuggestions("l"), engine.getAutocompleteSuggestions("l"));
+    EXPECT_EQ(loaded.getSpellingSuggestions("langauge"), engine.getSpellingSuggestions("langauge"));
+}
+
+TEST_F(SearchEngineTest, LoadIndexRejectsDamagedFiles) {
+    engine.addDocument("doc1", "test_doc1.txt");
+    ASSERT_TRUE(engine.saveIndex("test_index.bin"));
+    
+    std::ifstream in("test_index.bin", std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    
+    auto write_file = [](const std::string& content) {
+        std::ofstream out("test_index.bin", std::ios::binary | std::ios::trunc);
+        out << content;
+    };
+    
+    SearchEngine other;
+    other.addDocument("doc2", "test_doc2.txt");
+    other.addDocument("doc3", "test_doc3.txt");
+    
+    // Truncated file
+    write_file(bytes.substr(0, bytes.size() / 2));
+    EXPECT_FALSE(other.loadIndex("test_index.bin"));
+    
+    // Unknown format version
+    std::string future = bytes;
+    future[8] = 99;
+    write_file(future);
+    EXPECT_FALSE(other.loadIndex("test_index.bin"));
+    
+    // A failed load leaves the engine as it was
+    EXPECT_EQ(other.getDocumentCount(), 2);
+    EXPECT_FALSE(other.search("neural").empty());
+}
+
+TEST_F(SearchEngineTest, LoadedIndexesNeverFailQueries) {
+    // Enough documents for sealed blocks, with positions
+    std::vector<std::pair<std::string, std::string>> documents;
+    for (int i = 0; i < 300; i++) {
+        std::string path = "damaged_doc" + std::to_string(i) + ".txt";
+        createTestFile(path, std::string("common words ") + (i % 3 == 0 ? "fizz " : "") +
+                                 (i % 5 == 0 ? "buzz " : "") + "term" + std::to_string(i % 7));
+        documents.emplace_back("doc" + std::to_string(i), path);
+    }
+    engine.addDocuments(documents);
+    for (const auto& document : documents) std::remove(document.second.c_str());
+    ASSERT_TRUE(engine.saveIndex("test_index.bin"));
+    
+    std::ifstream in("test_index.bin", std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    
+    // Damaged files either fail to load or answer every query
+    const std::vector<std::string> queries = {"fizz buzz", "common fizz", "term3", "fizz AND NOT buzz",
+                                              "\"common words\"", "fizz NEAR/2 term0", "(fizz OR buzz) AND term1"};
+    std::mt19937 rng(12);
+    size_t loaded_count = 0;
+    for (int trial = 0; trial < 200; trial++) {
+        std::string damaged = bytes;
+        for (int i = 0; i < 4; i++) damaged[rng() % damaged.size()] = static_cast<char>(rng());
+        std::ofstream("test_index.bin", std::ios::binary | std::ios::trunc) << damaged;
+        
+        SearchEngine loaded;
+        if (!loaded.loadIndex("test_index.bin")) continue;
+        ++loaded_count;
+        for (auto strategy : {SearchEngine::ScoringStrategy::TermAtATime, SearchEngine::ScoringStrategy::BlockMaxWand}) {
+            loaded.setScoringStrategy(strategy);
+            for (const auto& query : queries) {
+                EXPECT_NO_THROW(loaded.search(query, 5)) << query;
+                EXPECT_NO_THROW({
+                    auto it = loaded.searchIterator(query);
+                    while (it.hasNext()) it.next();
+                }) << query;
+            }
+        }
+        EXPECT_NO_THROW(loaded.getAutocompleteSuggestions("te"));
+        EXPECT_NO_THROW(loaded.getSpellingSuggestions("fuzz"));
+    }
+    EXPECT_GT(loaded_count, 0u);
+}
+
+TEST(IndexSegmentTest, ReadsIndexInPlace) {
+    // Enough documents for sealed blocks plus a tail
+    InvertedIndex index;
+    index.setStoreImpacts(true);
+    for (int i = 0; i < 300; i++) {
+        std::string path = "segment_doc.txt";
+        std::ofstream(path) << "common " << (i % 3 == 0 ? "fizz " : "") << std::string(i % 5 + 1, 'z');
+        auto doc = std::make_shared<Document>("doc" + std::to_string(i), path);
+        ASSERT_TRUE(doc->parse());
+        index.addDocument(doc);
+    }
+    std::remove("segment_doc.txt");
+    
+    auto segment = IndexSegment::fromIndex(index);
+    EXPECT_EQ(segment->getTotalDocuments(), 300u);
+    EXPECT_EQ(segment->getTermCount(), index.getTermCount());
+    EXPECT_TRUE(segment->hasImpacts());
+    EXPECT_EQ(segment->getTermId("missing"), InvertedIndex::kInvalidId);
+    
+    for (const char* term : {"common", "fizz", "zzz"}) {
+        uint32_t term_id = segment->getTermId(term);
+        ASSERT_NE(term_id, InvertedIndex::kInvalidId);
+        EXPECT_EQ(segment->getTerm(term_id), term);
+        
+        const PostingList& expected = index.getPostings(term);
+        PostingList::View postings = segment->getPostings(term_id);
+        ASSERT_EQ(postings.size, expected.size());
+        EXPECT_EQ(segment->getMaxTermFrequency(term_id), expected.getMaxTermFrequency());
+        
+        uint32_t doc_ids[PostingList::kBlockSize];
+        uint32_t term_frequencies[PostingList::kBlockSize];
+        std::vector<PostingList::Posting> decoded;
+        for (size_t b = 0; b < postings.num_blocks; ++b) {
+            size_t count = postings.decodeDocIds(b, doc_ids);
+            postings.decodeTermFrequencies(b, term_frequencies);
+            for (size_t i = 0; i < count; ++i) decoded.push_back({doc_ids[i], term_frequencies[i]});
+        }
+        auto reference = expected.decode();
+        ASSERT_EQ(decoded.size(), reference.size());
+        for (size_t i = 0; i < decoded.size(); ++i) {
+            EXPECT_EQ(decoded[i].doc_id, reference[i].doc_id);
+            EXPECT_EQ(decoded[i].term_frequency, reference[i].term_frequency);
+        }
+    }
+    
+    EXPECT_EQ(segment->findDocument("doc123"), 123u);
+    EXPECT_EQ(segment->getDocumentId(123), "doc123");
+    EXPECT_EQ(segment->getDocumentPath(0), "segment_doc.txt");
+    EXPECT_EQ(segment->findDocument("doc300"), InvertedIndex::kInvalidId);
+    
+    // Bytes that are not a segment are rejected up front
+    std::string garbage(64, 'x');
+    EXPECT_THROW(IndexSegment(nullptr, garbage.data(), garbage.size()), std::runtime_error);
+}
+
+TEST_F(SearchEngineTest, LoadedSegmentsAcceptNewDocuments) {
+    engine.addDocument("doc1", "test_doc1.txt");
+    engine.addDocument("doc2", "test_doc2.txt");
+    ASSERT_TRUE(engine.saveIndex("test_index.bin"));
+    
+    // New documents land next to the mapped segment, and scores use the
+    // statistics of both
+    SearchEngine loaded;
+    ASSERT_TRUE(loaded.loadIndex("test_index.bin"));
+    loaded.addDocument("doc3", "test_doc3.txt");
+    EXPECT_THROW(loaded.addDocument("doc1", "test_doc3.txt"), std::invalid_argument);
+    
+    SearchEngine direct;
+    direct.addDocument("doc1", "test_doc1.txt");
+    direct.addDocument("doc2", "test_doc2.txt");
+    direct.addDocument("doc3", "test_doc3.txt");
+    
+    // Saving again writes the loaded segment plus one for doc3
+    ASSERT_TRUE(loaded.saveIndex("test_index.bin"));
+    SearchEngine reloaded;
+    ASSERT_TRUE(reloaded.loadIndex("test_index.bin"));
+    
+    for (auto strategy : {SearchEngine::ScoringStrategy::TermAtATime, SearchEngine::ScoringStrategy::BlockMaxWand}) {
+        for (SearchEngine* candidate : {&loaded, &reloaded, &direct}) candidate->setScoringStrategy(strategy);
+        for (const char* query : {"learning", "language", "machine learning language"}) {
+            auto expected = direct.search(query);
+            for (SearchEngine* candidate : {&loaded, &reloaded}) {
+                auto actual = candidate->search(query);
+                ASSERT_EQ(actual.size(), expected.size()) << query;
+                for (size_t i = 0; i < actual.size(); i++) {
+                    EXPECT_EQ(actual[i].first, expected[i].first);
+                    EXPECT_DOUBLE_EQ(actual[i].second, expected[i].second);
+                }
+            }
+        }
+    }
+    EXPECT_EQ(reloaded.getDocumentCount(), 3);
+}
+TEST_F(SearchEngineTest, SegmentedIngestionMatchesSingleIndex) {
+    const char* words[] = {"alpha", "beta", "gamma", "delta", "epsilon", "zeta", "eta", "theta"};
+    std::vector<std::pair<std::string, std::string>> documents;
+    for (int i = 0; i < 48; i++) {
+        std::string path = "segmented_" + std::to_string(i) + ".txt";
+        std::ofstream file(path);
+        for (int w = 0; w < 8; w++) {
+            if ((i + 1) % (w + 1) == 0) file << words[w] << ' ' << (w % 2 ? words[(i + w) % 8] : "") << ' ';
+        }
+        documents.emplace_back("seg" + std::to_string(i), path);
+    }
+    
+    // Tiny write buffers force many flushes and background merges
+    engine.setFlushThreshold(2);
+    SearchEngine direct;
+    for (size_t i = 0; i < 32; i++) {
+        engine.addDocument(documents[i].first, documents[i].second);
+        direct.addDocument(documents[i].first, documents[i].second);
+    }
+    std::vector<std::pair<std::string, std::string>> batch(documents.begin() + 32, documents.end());
+    engine.addDocuments(batch);
+    direct.addDocuments(batch);
+    engine.addDocument("doc1", "test_doc1.txt");
+    direct.addDocument("doc1", "test_doc1.txt");
+    EXPECT_THROW(engine.addDocument("seg3", "test_doc2.txt"), std::invalid_argument);
+    engine.waitForMerges();
+    
+    // Tiered merging keeps the segment count logarithmic
+    EXPECT_EQ(engine.getDocumentCount(), 49);
+    EXPECT_LE(engine.getSegmentCount(), 6u);
+    EXPECT_EQ(direct.getSegmentCount(), 0u);
+    
+    for (auto strategy : {SearchEngine::ScoringStrategy::TermAtATime, SearchEngine::ScoringStrategy::BlockMaxWand}) {
+        engine.setScoringStrategy(strategy);
+        direct.setScoringStrategy(strategy);
+        for (const char* query : {"alpha", "beta gamma", "delta zeta theta", "machine epsilon"}) {
+            auto expected = direct.search(query, 20);
+            auto actual = engine.search(query, 20);
+            ASSERT_EQ(actual.size(), expected.size()) << query;
+            for (size_t i = 0; i < actual.size(); i++) {
+                EXPECT_EQ(actual[i].first, expected[i].first) << query;
+                EXPECT_NEAR(actual[i].second, expected[i].second, 1e-9) << query;
+            }
+        }
+    }
+    
+    for (const auto& document : documents) std::remove(document.second.c_str());
+}
+
+TEST_F(SearchEngineTest, BufferedChunksMatchOneBatch) {
+    const char* words[] = {"alpha", "beta", "gamma", "delta", "epsilon", "zeta", "eta", "theta"};
+    std::vector<std::pair<std::string, std::string>> documents;
+    for (int i = 0; i < 300; i++) {
+        std::string path = "chunked_" + std::to_string(i) + ".txt";
+        std::ofstream file(path);
+        for (int w = 0; w < 8; w++) {
+            if ((i + 1) % (w + 1) == 0) file << words[w] << ' ' << words[(i * 7 + w) % 8] << ' ';
+        }
+        documents.emplace_back("chunk" + std::to_string(i), path);
+    }
+    
+    // Documents added one at a time are frozen into buffer chunks as they
+    // arrive; they stay in the write buffer and score like one batch
+    SearchEngine batched;
+    batched.addDocuments(documents);
+    for (const auto& [id, path] : documents) engine.addDocument(id, path);
+    EXPECT_EQ(engine.getDocumentCount(), 300);
+    EXPECT_EQ(engine.getSegmentCount(), 0u);
+    EXPECT_THROW(engine.addDocument("chunk5", "test_doc1.txt"), std::invalid_argument);
+    for (const auto& document : documents) std::remove(document.second.c_str());
+    
+    auto expect_same = [&batched](const SearchEngine& actual_engine) {
+        for (const char* query : {"alpha", "beta gamma", "delta zeta theta", "alpha AND NOT beta"}) {
+            auto expected = batched.search(query, 50);
+            auto actual = actual_engine.search(query, 50);
+            ASSERT_EQ(actual.size(), expected.size()) << query;
+            for (size_t i = 0; i < actual.size(); i++) {
+                EXPECT_EQ(actual[i].first, expected[i].first) << query;
+                EXPECT_NEAR(actual[i].second, expected[i].second, 1e-9) << query;
+            }
+        }
+    };
+    expect_same(engine);
+    
+    ASSERT_TRUE(engine.saveIndex("test_index.bin"));
+    SearchEngine loaded;
+    ASSERT_TRUE(loaded.loadIndex("test_index.bin"));
+    expect_same(loaded);
+    
+    // Flushing turns the whole buffer into one segment
+    engine.flush();
+    EXPECT_EQ(engine.getSegmentCount(), 1u);
+    expect_same(engine);
+}
+
+TEST(HuffmanCompressionTest, TableDecoderRoundTrips) {
+    std::mt19937 rng(7);
+    std::string text;
+    for (int i = 0; i < 20000; i++) text += "the quick brown fox "[rng() % 20];
+    
+    // Geometric frequencies give codes longer than one table probe covers
+    std::string skewed;
+    for (int c = 0; c < 40; c++) skewed.append(size_t{1} << std::min(c, 16), static_cast<char>('A' + c));
+    std::shuffle(skewed.begin(), skewed.end(), rng);
+    
+    std::string binary;
+    for (int i = 0; i < 5000; i++) binary += static_cast<char>(rng() % 256);
+    
+    HuffmanCompression huffman;
+    for (const std::string& input : {text, skewed, binary, std::string(1000, 'x'), std::string("a")}) {
+        auto compressed = huffman.compress(input);
+        EXPECT_EQ(huffman.decompress(compressed), input);
+    }
+    EXPECT_LT(huffman.getCompressionRatio(text, huffman.compress(text)), 0.5);
+    
+    // Data cut short is rejected instead of decoded past its end
+    auto compressed = huffman.compress(text);
+    compressed.resize(compressed.size() / 2);
+    EXPECT_THROW(huffman.decompress(compressed), std::runtime_error);
+}
+TEST(HuffmanCompressionTest, StreamsAreSelfDescribing) {
+    std::string text;
+    for (int i = 0; i < 1000; i++) text += "abracadabra " + std::to_string(i % 7);
+    
+    // A coder that never saw the input decodes it from the stream alone
+    auto compressed = HuffmanCompression().compress(text);
+    EXPECT_EQ(HuffmanCompression().decompress(compressed), text);
+    
+    // Header: size, symbol bitmap and 5-bit lengths of the 16 symbols used
+    EXPECT_LE(compressed.size(), 8 + 32 + 10 + text.size() / 2);
+    EXPECT_TRUE(HuffmanCompression().compress("").empty());
+    EXPECT_EQ(HuffmanCompression().decompress({}), "");
+    
+    // Lengths that cannot form a prefix code are rejected
+    auto damaged = compressed;
+    std::fill(damaged.begin() + 40, damaged.begin() + 50, 0x08);
+    EXPECT_THROW(HuffmanCompression().decompress(damaged), std::runtime_error);
+    damaged.resize(20);
+    EXPECT_THROW(HuffmanCompression().decompress(damaged), std::runtime_error);
+}
+TEST(CompressedFileTest, ParallelBlocksRoundTrip) {
+    std::mt19937 rng(11);
+    std::string data;
+    for (int i = 0; i < 50000; i++) data += "index segment "[rng() % 14];
+    
+    // Small blocks and uneven writes exercise block boundaries and the
+    // bound on blocks in flight
+    ThreadPool pool(4);
+    std::ostringstream out;
+    CompressedFile::Writer writer(out, pool, *Codec::get(Codec::Id::Huffman), 1000);
+    for (size_t offset = 0; offset < data.size(); offset += 777) {
+        writer.write(data.data() + offset, std::min<size_t>(777, data.size() - offset));
+    }
+    ASSERT_TRUE(writer.finish());
+    
+    std::string compressed = out.str();
+    ASSERT_TRUE(CompressedFile::isCompressed(compressed.data(), compressed.size()));
+    EXPECT_LT(compressed.size(), data.size());
+    EXPECT_EQ(CompressedFile::decompress(compressed.data(), compressed.size(), pool), data);
+    
+    // Damaged block indexes and blocks are rejected
+    std::string damaged = compressed;
+    damaged[damaged.size() - 40] ^= 0x01;
+    EXPECT_THROW(CompressedFile::decompress(damaged.data(), damaged.size(), pool), std::runtime_error);
+    damaged = compressed;
+    damaged.erase(100, 1);
+    EXPECT_THROW(CompressedFile::decompress(damaged.data(), damaged.size(), pool), std::runtime_error);
+    
+    // So are sizes that would allocate more than the blocks can hold: an
+    // oversized block size, and a raw size past what a block stream codes
+    damaged = compressed;
+    std::memset(&damaged[12], 0xff, 4);
+    EXPECT_THROW(CompressedFile::decompress(damaged.data(), damaged.size(), pool), std::runtime_error);
+    damaged = compressed;
+    uint64_t index_offset;
+    std::memcpy(&index_offset, damaged.data() + damaged.size() - 16, sizeof(index_offset));
+    uint64_t huge = uint64_t{1} << 40;
+    std::memcpy(&damaged[index_offset + 16], &huge, sizeof(huge));
+    EXPECT_THROW(CompressedFile::decompress(damaged.data(), damaged.size(), pool), std::runtime_error);
+}
+
+TEST_F(SearchEngineTest, CompressedIndexRoundTrip) {
+    engine.addDocument("doc1", "test_doc1.txt");
+    engine.addDocument("doc2", "test_doc2.txt");
+    engine.addDocument("large", "large_doc.txt");
+    engine.flush();
+    engine.addDocument("doc3", "test_doc3.txt");
+    
+    ASSERT_TRUE(engine.saveIndex("test_index.bin"));
+    size_t raw_size = std::ifstream("test_index.bin", std::ios::binary | std::ios::ate).tellg();
+    
+    // Each file records its codec, so one engine loads either kind
+    for (auto compression : {SearchEngine::IndexCompression::Huffman, SearchEngine::IndexCompression::Rans}) {
+        ASSERT_TRUE(engine.saveIndex("test_index.bin", compression));
+        size_t compressed_size = std::ifstream("test_index.bin", std::ios::binary | std::ios::ate).tellg();
+        EXPECT_LT(compressed_size, raw_size);
+        
+        SearchEngine loaded;
+        ASSERT_TRUE(loaded.loadIndex("test_index.bin"));
+        EXPECT_EQ(loaded.getDocumentCount(), 4);
+        for (const char* query : {"machine learning", "language", "neural networks"}) {
+            auto expected = engine.search(query);
+            auto actual = loaded.search(query);
+            ASSERT_EQ(actual.size(), expected.size());
+            for (size_t i = 0; i < actual.size(); i++) {
+                EXPECT_EQ(actual[i].first, expected[i].first);
+                EXPECT_DOUBLE_EQ(actual[i].second, expected[i].second);
+            }
+        }
+        
+        // A block size no writer produces fails the load instead of
+        // allocating for it
+        std::string bytes;
+        {
+            std::ifstream in("test_index.bin", std::ios::binary);
+            bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        std::memset(&bytes[12], 0xff, 4);
+        std::ofstream("test_index.bin", std::ios::binary).write(bytes.data(), bytes.size());
+        EXPECT_FALSE(loaded.loadIndex("test_index.bin"));
+        EXPECT_EQ(loaded.getDocumentCount(), 4);
+    }
+}
+
+TEST(RansCompressionTest, RoundTripsAndBeatsHuffmanOnSkewedData) {
+    std::mt19937 rng(5);
+    std::string skewed;
+    for (int i = 0; i < 100000; i++) skewed += (rng() % 10 == 0) ? "bcdefgh"[rng() % 7] : 'a';
+    std::string binary;
+    for (int i = 0; i < 5000; i++) binary += static_cast<char>(rng() % 256);
+    
+    RansCompression rans;
+    for (const std::string& input : {skewed, binary, std::string(1000, 'x'), std::string("a")}) {
+        auto compressed = rans.compress(input.data(), input.size());
+        std::string output(input.size(), '\0');
+        rans.decompress(compressed.data(), compressed.size(), output.data(), output.size());
+        EXPECT_EQ(output, input);
+    }
+    
+    // Huffman spends at least a bit per byte; rANS approaches the entropy
+    size_t rans_size = rans.compress(skewed.data(), skewed.size()).size();
+    size_t huffman_size = HuffmanCompression().compress(skewed).size();
+    EXPECT_LT(rans_size * 10, huffman_size * 7);
+    
+    // A single distinct byte owns every probability slot and costs nothing
+    // beyond the header and final states
+    std::string zeros(1 << 20, '\0');
+    auto single = rans.compress(zeros.data(), zeros.size());
+    EXPECT_LT(single.size(), 64u);
+    std::string restored(zeros.size(), 'x');
+    rans.decompress(single.data(), single.size(), restored.data(), restored.size());
+    EXPECT_EQ(restored, zeros);
+    
+    auto compressed = rans.compress(skewed.data(), skewed.size());
+    compressed[compressed.size() / 2] ^= 0x10;
+    std::string output(skewed.size(), '\0');
+    EXPECT_THROW(rans.decompress(compressed.data(), compressed.size(), output.data(), output.size()),
+                 std::runtime_error);
+}
+
+TEST(QueryTest, ParsesPhrasesAndNearOperators) {
+    using Kind = Query::Node::Kind;
+    Query query = Query::parse("deep \"Machine, Learning\" NEAR/3 models near NEAR/x \"single\" NEAR/2");
+    EXPECT_EQ(query.terms, (std::vector<std::string>{"deep", "machine", "learning", "models", "near", "nearx", "single"}));
+    
+    // Juxtaposed phrase and NEAR constraints are required, the rest only rank
+    ASSERT_TRUE(query.filter);
+    ASSERT_EQ(query.filter->kind, Kind::And);
+    ASSERT_EQ(query.filter->children.size(), 2u);
+    const Query::Proximity& phrase = query.filter->children[0].proximity;
+    EXPECT_EQ(phrase.kind, Query::Proximity::Kind::Phrase);
+    EXPECT_EQ(phrase.terms, (std::vector<std::string>{"machine", "learning"}));
+    const Query::Proximity& near = query.filter->children[1].proximity;
+    EXPECT_EQ(near.kind, Query::Proximity::Kind::Near);
+    EXPECT_EQ(near.terms, (std::vector<std::string>{"learning", "models"}));
+    EXPECT_EQ(near.distance, 3u);
+    
+    EXPECT_FALSE(Query::parse("plain terms OR more").filter);
+}
+
+TEST_F(SearchEngineTest, PhraseAndProximityQueries) {
+    const std::vector<std::pair<std::string, std::string>> texts = {
+        {"p1", "machine learning is fun"},
+        {"p2", "learning about the machine"},
+        {"p3", "the learning machine learns"},
+        {"p4", "nothing relevant here"},
+        {"p5", "machine learning again"}};
+    for (const auto& [id, text] : texts) createTestFile(id + ".txt", text);
+    
+    // Positions survive flushes and merges of the segments that hold them;
+    // p5 is indexed without positions and so never matches an operator
+    engine.setFlushThreshold(1);
+    for (size_t i = 0; i < 4; i++) engine.addDocument(texts[i].first, texts[i].first + ".txt");
+    engine.waitForMerges();
+    EXPECT_EQ(engine.getSegmentCount(), 1u);
+    EXPECT_TRUE(engine.getPositionIndexing());
+    engine.setPositionIndexing(false);
+    engine.addDocument("p5", "p5.txt");
+    
+    auto ids = [](const std::vector<std::pair<std::string, double>>& results) {
+        std::vector<std::string> sorted;
+        for (const auto& result : results) sorted.push_back(result.first);
+        std::sort(sorted.begin(), sorted.end());
+        return sorted;
+    };
+    const std::vector<std::pair<std::string, std::vector<std::string>>> expected = {
+        {"\"machine learning\"", {"p1"}},
+        {"\"learning machine\"", {"p3"}},
+        {"\"learning machine learns\" fun", {"p3"}},
+        {"machine NEAR/1 learning", {"p1", "p3"}},
+        {"machine NEAR/3 learning", {"p1", "p2", "p3"}},
+        {"\"machine learning\" NEAR/2 fun", {"p1"}},
+        {"\"machine learning\" \"learning machine\"", {}},
+        {"machine learning", {"p1", "p2", "p3", "p5"}}};
+    
+    ASSERT_TRUE(engine.saveIndex("test_index.bin"));
+    SearchEngine loaded;
+    ASSERT_TRUE(loaded.loadIndex("test_index.bin"));
+    for (SearchEngine* candidate : {&engine, &loaded}) {
+        for (const auto& [query, documents] : expected) {
+            EXPECT_EQ(ids(candidate->search(query)), documents) << query;
+        }
+        auto iterator = candidate->searchIterator("machine NEAR/1 learning");
+        size_t pulled = 0;
+        for (; iterator.hasNext(); iterator.next()) pulled++;
+        EXPECT_EQ(pulled, 2u);
+    }
+    
+    for (const auto& [id, text] : texts) std::remove((id + ".txt").c_str());
+}
+
+TEST(QueryTest, ParsesBooleanOperators) {
+    using Kind = Query::Node::Kind;
+    Query query = Query::parse("(cats OR dogs) AND NOT \"hot dogs\" pets AND");
+    EXPECT_EQ(query.terms, (std::vector<std::string>{"cats", "dogs", "pets"}));
+    
+    ASSERT_TRUE(query.filter);
+    const Query::Node& root = *query.filter;
+    ASSERT_EQ(root.kind, Kind::And);
+    ASSERT_EQ(root.children.size(), 3u);
+    EXPECT_EQ(root.children[0].kind, Kind::Or);
+    EXPECT_EQ(root.children[0].children.size(), 2u);
+    EXPECT_EQ(root.children[1].term, "pets");
+    ASSERT_EQ(root.children[2].kind, Kind::Not);
+    EXPECT_EQ(root.children[2].children[0].kind, Kind::Proximity);
+}
+
+TEST_F(SearchEngineTest, DeeplyNestedQueriesMatchNothing) {
+    engine.addDocument("doc1", "test_doc1.txt");
+    engine.addDocument("doc2", "test_doc2.txt");
+    auto repeat = [](const std::string& piece, size_t count) {
+        std::string text;
+        for (size_t i = 0; i < count; i++) text += piece;
+        return text;
+    };
+    
+    // Nesting up to the limit parses; deeper queries are rejected whole
+    size_t limit = Query::kMaxDepth;
+    EXPECT_EQ(engine.search(repeat("(", limit) + "machine" + repeat(")", limit)).size(), 1u);
+    EXPECT_EQ(engine.search(repeat("NOT NOT ", limit / 2) + "machine").size(), 1u);
+    for (size_t depth : {limit + 1, size_t{100000}}) {
+        Query parsed = Query::parse(repeat("(", depth) + "machine");
+        EXPECT_TRUE(parsed.terms.empty());
+        EXPECT_FALSE(parsed.filter);
+        EXPECT_TRUE(engine.search(repeat("(", depth) + "machine").empty());
+        EXPECT_TRUE(engine.search(repeat("NOT ", depth) + "machine").empty());
+        EXPECT_TRUE(engine.search("machine AND " + repeat("NOT ", depth) + "apple").empty());
+    }
+}
+
+TEST(IntersectionTest, MergeAndGallopMatchReference) {
+    std::mt19937 rng(11);
+    auto sorted = [&rng](size_t size, uint32_t range) {
+        std::vector<uint32_t> values(size);
+        for (auto& value : values) value = rng() % range;
+        std::sort(values.begin(), values.end());
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+        return values;
+    };
+    for (auto [a_size, b_size] : {std::pair<size_t, size_t>{1000, 1200}, {10, 5000}, {3, 7}, {0, 10}}) {
+        std::vector<uint32_t> a = sorted(a_size, 8000);
+        std::vector<uint32_t> b = sorted(b_size, 8000);
+        std::vector<uint32_t> expected;
+        std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+        
+        std::vector<uint32_t> out(std::min(a.size(), b.size()));
+        out.resize(Intersection::intersect(a.data(), a.size(), b.data(), b.size(), out.data()));
+        EXPECT_EQ(out, expected);
+        out.resize(std::min(a.size(), b.size()));
+        out.resize(Intersection::merge(a.data(), a.size(), b.data(), b.size(), out.data()));
+        EXPECT_EQ(out, expected);
+        out.resize(std::min(a.size(), b.size()));
+        out.resize(Intersection::gallop(a.data(), a.size(), b.data(), b.size(), out.data()));
+        EXPECT_EQ(out, expected);
+    }
+}
+
+TEST_F(SearchEngineTest, BooleanQueriesMatchReference) {
+    // Term i of a document is present when (doc + 1) is divisible by its
+    // modulus, so reference results follow from arithmetic alone
+    const std::vector<std::pair<std::string, int>> terms = {
+        {"red", 2}, {"green", 3}, {"blue", 5}, {"cyan", 7}, {"rare", 97}};
+    const int documents = 600;
+    std::vector<std::pair<std::string, std::string>> batch;
+    for (int i = 0; i < documents; i++) {
+        std::string path = "boolean_" + std::to_string(i) + ".txt";
+        std::ofstream file(path);
+        file << "filler ";
+        for (const auto& [term, modulus] : terms) {
+            if ((i + 1) % modulus == 0) file << term << ' ';
+        }
+        batch.emplace_back("b" + std::to_string(i), path);
+    }
+    engine.setFlushThreshold(150);
+    engine.addDocuments(batch);
+    
+    auto has = [&terms](int i, const std::string& term) {
+        for (const auto& [name, modulus] : terms) {
+            if (name == term) return (i + 1) % modulus == 0;
+        }
+        return false;
+    };
+    const std::vector<std::pair<std::string, std::function<bool(int)>>> queries = {
+        {"red AND green", [&](int i) { return has(i, "red") && has(i, "green"); }},
+        {"red AND green AND blue", [&](int i) { return has(i, "red") && has(i, "green") && has(i, "blue"); }},
+        {"rare AND red", [&](int i) { return has(i, "rare") && has(i, "red"); }},
+        {"(red OR blue) AND NOT green", [&](int i) { return (has(i, "red") || has(i, "blue")) && !has(i, "green"); }},
+        {"cyan NOT red", [&](int i) { return has(i, "cyan") && !has(i, "red"); }},
+        {"red AND (green OR cyan) AND blue", [&](int i) {
+            return has(i, "red") && (has(i, "green") || has(i, "cyan")) && has(i, "blue"); }},
+        {"red AND missing", [](int) { return false; }},
+        {"NOT red", [&](int i) { return !has(i, "red"); }},
+        {"NOT rare", [&](int i) { return !has(i, "rare"); }},
+        {"filler AND NOT (red OR green)", [&](int i) { return !has(i, "red") && !has(i, "green"); }}};
+    
+    for (const auto& [query, matches] : queries) {
+        std::vector<std::string> expected;
+        for (int i = 0; i < documents; i++) {
+            if (matches(i)) expected.push_back("b" + std::to_string(i));
+        }
+        std::vector<std::string> actual;
+        for (const auto& result : engine.search(query, documents)) actual.push_back(result.first);
+        std::sort(expected.begin(), expected.end());
+        std::sort(actual.begin(), actual.end());
+        EXPECT_EQ(actual, expected) << query;
+    }
+    
+    // Ranking is unchanged: a conjunction scores like the plain query
+    auto conjunctive = engine.search("red AND green", 5);
+    auto plain = engine.search("red green", 5);
+    ASSERT_EQ(conjunctive.size(), 5u);
+    for (size_t i = 0; i < conjunctive.size(); i++) {
+        EXPECT_EQ(conjunctive[i].first, plain[i].first);
+        EXPECT_DOUBLE_EQ(conjunctive[i].second, plain[i].second);
+    }
+    
+    for (const auto& document : batch) std::remove(document.second.c_str());
+}
+
+TEST(ResultCacheTest, EvictsLeastRecentlyUsedAndStaleGenerations) {
+    // One entry per shard: keys landing in the same shard evict each other
+    ResultCache cache(ResultCache::kShards);
+    ResultCache::Results results = {{"doc", 1.0}};
+    
+    cache.insert("a", 1, results);
+    auto hit = cache.lookup("a", 1);
+    ASSERT_NE(hit, nullptr);
+    EXPECT_EQ(*hit, results);
+    
+    // A newer generation misses and drops the entry; an older one cannot
+    // replace it
+    EXPECT_EQ(cache.lookup("a", 2), nullptr);
+    EXPECT_EQ(cache.getStats().entries, 0u);
+    cache.insert("a", 3, results);
+    cache.insert("a", 2, {});
+    ASSERT_NE(cache.lookup("a", 3), nullptr);
+    EXPECT_EQ(cache.lookup("a", 3)->size(), 1u);
+    
+    // Filling the cache keeps at most one entry per shard
+    for (int i = 0; i < 100; i++) {
+        cache.insert("key" + std::to_string(i), 3, results);
+    }
+    EXPECT_LE(cache.getStats().entries, ResultCache::kShards);
+    ASSERT_NE(cache.lookup("key99", 3), nullptr);
+    
+    ResultCache::Stats stats = cache.getStats();
+    EXPECT_EQ(stats.hits, 4u);
+    EXPECT_EQ(stats.misses, 1u);
+    
+    cache.setCapacity(0);
+    EXPECT_EQ(cache.getStats().entries, 0u);
+}
+
+TEST_F(SearchEngineTest, ResultCacheServesRepeatedQueries) {
+    engine.addDocument("doc1", "test_doc1.txt");
+    engine.addDocument("doc2", "test_doc2.txt");
+    
+    auto first = engine.search("machine", 10);
+    // Spacing and case do not change the normalized query
+    auto second = engine.search("  Machine ", 10);
+    EXPECT_EQ(second, first);
+    ResultCache::Stats stats = engine.getResultCacheStats();
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.hits, 1u);
+    
+    // A different result count is a different entry
+    engine.search("machine", 1);
+    EXPECT_EQ(engine.getResultCacheStats().misses, 2u);
+    
+    // Adding a document publishes a new generation, so the cached results
+    // are not reused
+    createTestFile("test_doc4.txt", "machine machine machine");
+    engine.addDocument("doc4", "test_doc4.txt");
+    auto updated = engine.search("machine", 10);
+    EXPECT_EQ(engine.getResultCacheStats().misses, 3u);
+    ASSERT_FALSE(updated.empty());
+    EXPECT_EQ(updated[0].first, "doc4");
+    std::remove("test_doc4.txt");
+    
+    // Without a cache every query is evaluated
+    engine.setResultCacheCapacity(0);
+    EXPECT_EQ(engine.search("machine", 10), updated);
+    EXPECT_EQ(engine.getResultCacheStats().hits, 1u);
+    EXPECT_EQ(engine.getResultCacheStats().entries, 0u);
+}
+
+TEST(TrieTest, MatchesReferenceDictionary) {
+    // Words over a 40-letter alphabet, so nodes near the root outgrow the
+    // small child runs and are searched by bisection
+    const std::string alphabet = "abcdefghijklmnopqrstuvwxyz0123456789\x80\xc3\xe9\xff";
+    std::mt19937 rng(21);
+    std::map<std::string, size_t> reference;
+    Trie trie(8);
+    for (int i = 0; i < 5000; i++) {
+        std::string word;
+        size_t length = 1 + rng() % 6;
+        for (size_t j = 0; j < length; j++) word += alphabet[rng() % alphabet.size()];
+        size_t count = 1 + rng() % 3;
+        trie.insert(word, count);
+        reference[word] += count;
+    }
+    EXPECT_EQ(trie.size(), reference.size());
+    
+    for (const auto& [word, frequency] : reference) {
+        ASSERT_TRUE(trie.contains(word)) << word;
+        EXPECT_FALSE(trie.contains(word + "\x01"));
+    }
+    EXPECT_FALSE(trie.contains("abcdefghij"));
+    
+    // Most frequent first, alphabetically among equals
+    auto expectedSuggestions = [&reference](const std::string& prefix) {
+        std::vector<std::pair<std::string, size_t>> words;
+        for (auto it = reference.lower_bound(prefix);
+             it != reference.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+            words.push_back(*it);
+        }
+        std::stable_sort(words.begin(), words.end(),
+                         [](const auto& a, const auto& b) { return a.second > b.second; });
+        std::vector<std::string> expected;
+        for (size_t i = 0; i < words.size() && i < 8; i++) expected.push_back(words[i].first);
+        return expected;
+    };
+    for (const std::string prefix : {"", "a", "q7", "\xff", "zz", "0a1"}) {
+        EXPECT_EQ(trie.getSuggestions(prefix), expectedSuggestions(prefix)) << prefix;
+    }
+    
+    // Serialized words come back with their frequencies
+    BinaryWriter writer;
+    trie.serialize(writer);
+    Trie copy(8);
+    BinaryReader reader(writer.data().data(), writer.size());
+    copy.deserialize(reader);
+    EXPECT_EQ(copy.size(), reference.size());
+    EXPECT_EQ(copy.getSuggestions("b"), expectedSuggestions("b"));
+    
+    trie.clear();
+    EXPECT_EQ(trie.size(), 0u);
+    EXPECT_TRUE(trie.getSuggestions("a").empty());
+}
+
+TEST(TrieTest, SuggestionsFollowPopularityUpdates) {
+    // Zipf-like frequencies with many ties, then popularity raised and
+    // lowered again
+    std::mt19937 rng(22);
+    std::map<std::string, size_t> reference;
+    Trie trie(5);
+    for (int i = 0; i < 20000; i++) {
+        std::string word = "w";
+        size_t length = 1 + rng() % 5;
+        for (size_t j = 0; j < length; j++) word += static_cast<char>('a' + rng() % 8);
+        size_t count = 1 + 1000 / (1 + rng() % 1000);
+        trie.insert(word, count);
+        reference[word] += count;
+    }
+    std::vector<std::string> words;
+    for (const auto& entry : reference) words.push_back(entry.first);
+    std::map<std::string, size_t> popularity;
+    for (int i = 0; i < 5000; i++) {
+        const std::string& word = words[rng() % words.size()];
+        size_t value = rng() % 3 == 0 ? 0 : rng() % 2000;
+        reference[word] += value - popularity[word];
+        popularity[word] = value;
+        trie.setPopularity(word, value);
+    }
+    trie.setPopularity("wzzz", 5000);
+    
+    for (const std::string prefix : {"", "w", "wa", "wab", "wh", "whhh", "wabcd", "x"}) {
+        std::vector<std::pair<std::string, size_t>> matches;
+        for (const auto& entry : reference) {
+            if (entry.first.compare(0, prefix.size(), prefix) == 0) matches.push_back(entry);
+        }
+        std::stable_sort(matches.begin(), matches.end(),
+                         [](const auto& a, const auto& b) { return a.second > b.second; });
+        std::vector<std::string> expected;
+        for (size_t i = 0; i < matches.size() && i < 5; i++) expected.push_back(matches[i].first);
+        EXPECT_EQ(trie.getSuggestions(prefix), expected) << prefix;
+    }
+}
+
+TEST(QueryLogTest, AggregatesDecaysAndBoundsTerms) {
+    std::map<std::string, size_t> published;
+    auto publisher = [&published](const std::vector<std::pair<std::string, size_t>>& changes) {
+        for (const auto& [term, popularity] : changes) published[term] = popularity;
+    };
+    // Aggregation runs only on flush; scores halve every 100 ms
+    QueryLog log(publisher, std::chrono::hours(1), std::chrono::milliseconds(100), 2);
+    
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&log]() {
+            for (int i = 0; i < 250; i++) log.record({"alpha", "beta"});
+            for (int i = 0; i < 50; i++) log.record({"gamma"});
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    log.record({"delta"});
+    log.flush();
+    
+    // Only the two highest scores are kept
+    EXPECT_GE(published["alpha"], 990u);
+    EXPECT_LE(published["alpha"], 1000u);
+    EXPECT_EQ(published["alpha"], published["beta"]);
+    EXPECT_EQ(published.count("gamma"), 0u);
+    EXPECT_EQ(published.count("delta"), 0u);
+    
+    // After five half-lives about 1/32 is left
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    log.flush();
+    EXPECT_LT(published["alpha"], 40u);
+    
+    // Republishing sends every tracked score again
+    published.clear();
+    log.republish();
+    log.flush();
+    EXPECT_GT(published["alpha"], 0u);
+    EXPECT_GT(published["beta"], 0u);
+}
+
+TEST_F(SearchEngineTest, QueriesRaiseAutocompletePopularity) {
+    // "networks" appears in three documents, "neural" in one
+    createTestFile("test_doc4.txt", "networks");
+    engine.addDocument("doc2", "test_doc2.txt");
+    engine.addDocument("doc4", "test_doc4.txt");
+    engine.addDocument("doc5", "test_doc4.txt");
+    EXPECT_EQ(engine.getAutocompleteSuggestions("ne")[0], "networks");
+    
+    // Queries are counted off the query path and show up once flushed
+    for (int i = 0; i < 5; i++) engine.search("neural", 10);
+    engine.flushQueryLog();
+    EXPECT_EQ(engine.getAutocompleteSuggestions("ne")[0], "neural");
+    
+    // Popularity survives reloading the index
+    ASSERT_TRUE(engine.saveIndex("test_index.bin"));
+    ASSERT_TRUE(engine.loadIndex("test_index.bin"));
+    engine.flushQueryLog();
+    EXPECT_EQ(engine.getAutocompleteSuggestions("ne")[0], "neural");
+    std::remove("test_doc4.txt");
+}
+
+TEST(TermDictionaryTest, MatchesSortedReference) {
+    // Words with shared prefixes and suffixes, and bytes above 0x7f
+    std::mt19937 rng(24);
+    const std::vector<std::string> stems = {"run", "walk", "jump", "read", "writ", "\xc3\xa9t"};
+    const std::vector<std::string> suffixes = {"", "s", "er", "ers", "ing", "ed", "able"};
+    std::vector<std::string> words;
+    for (int i = 0; i < 3000; i++) {
+        std::string word = stems[rng() % stems.size()];
+        size_t extra = rng() % 4;
+        for (size_t j = 0; j < extra; j++) word += static_cast<char>('a' + rng() % 26);
+        words.push_back(word + suffixes[rng() % suffixes.size()]);
+    }
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+    std::vector<std::string_view> terms(words.begin(), words.end());
+    std::vector<uint32_t> frequencies;
+    for (size_t i = 0; i < words.size(); i++) frequencies.push_back(static_cast<uint32_t>(i * 7 % 101));
+    
+    TermDictionary dictionary = TermDictionary::build(terms, frequencies.data());
+    ASSERT_EQ(dictionary.size(), words.size());
+    for (uint32_t id = 0; id < words.size(); id++) {
+        ASSERT_EQ(dictionary.find(words[id]), id);
+        ASSERT_EQ(dictionary.getTerm(id), words[id]);
+        EXPECT_EQ(dictionary.getFrequency(id), frequencies[id]);
+    }
+    EXPECT_EQ(dictionary.find("ru"), TermDictionary::kNotFound);
+    EXPECT_EQ(dictionary.find(""), TermDictionary::kNotFound);
+    
+    auto rank = [&words](const std::string& term) {
+        return static_cast<uint32_t>(std::lower_bound(words.begin(), words.end(), term) - words.begin());
+    };
+    for (const std::string probe : {"", "a", "jump", "jumpzzzz", "r", "runs", "walkz", "zzz", "\xc3", "\xff"}) {
+        EXPECT_EQ(dictionary.lowerBound(probe), rank(probe)) << probe;
+        std::string next = probe;
+        next.push_back('\xff');
+        auto expected = std::make_pair(rank(probe), rank(next));
+        EXPECT_EQ(dictionary.prefixRange(probe), expected) << probe;
+    }
+    EXPECT_EQ(dictionary.range("read", "walk"), std::make_pair(rank("read"), rank("walk")));
+    EXPECT_EQ(dictionary.range("walk", "read").first, dictionary.range("walk", "read").second);
+    
+    // Automaton accepting words of the "run" stem that end in "ing"; it
+    // gives up on paths that leave the stem
+    struct RunIng {
+        using State = std::string;
+        State start() const { return ""; }
+        State step(const State& state, unsigned char c) const { return state + static_cast<char>(c); }
+        bool isMatch(const State& state) const {
+            return state.size() >= 6 && state.compare(state.size() - 3, 3, "ing") == 0;
+        }
+        bool canMatch(const State& state) const {
+            return state.compare(0, std::min<size_t>(state.size(), 3), "run", 0, std::min<size_t>(state.size(), 3)) == 0;
+        }
+    };
+    std::vector<std::string> matched;
+    dictionary.intersect(RunIng(), [&](std::string_view term, uint32_t id) {
+        EXPECT_EQ(words[id], term);
+        matched.emplace_back(term);
+    });
+    std::vector<std::string> expected;
+    for (const auto& word : words) {
+        if (RunIng().canMatch(word) && RunIng().isMatch(word)) expected.push_back(word);
+    }
+    EXPECT_FALSE(expected.empty());
+    EXPECT_EQ(matched, expected);
+    
+    // Shared structure makes the automaton smaller than the strings alone
+    size_t string_bytes = 0;
+    for (const auto& word : words) string_bytes += word.size();
+    EXPECT_LT(TermDictionary::build(terms).memoryUsage(), string_bytes);
+    EXPECT_FALSE(TermDictionary::build(terms).hasFrequencies());
+    
+    // The bytes are used in place; bad ones and bad input are rejected
+    std::string bytes(dictionary.bytes());
+    auto copy = std::make_shared<const std::string>(bytes);
+    TermDictionary view(copy, copy->data(), copy->size());
+    EXPECT_EQ(view.find(words[42]), 42u);
+    EXPECT_THROW(TermDictionary(copy, copy->data(), 10), std::runtime_error);
+    EXPECT_THROW(TermDictionary::build({"b", "a"}), std::invalid_argument);
+    EXPECT_EQ(TermDictionary().size(), 0u);
+    EXPECT_EQ(TermDictionary().find("a"), TermDictionary::kNotFound);
+}
+
+TEST_F(SearchEngineTest, LongTermsSurviveFlushAndMerge) {
+    // Dictionary walks keep their own stack, so term length cannot
+    // overflow the call stack
+    std::string long_term(1000000, 'q');
+    TermDictionary dictionary = TermDictionary::build({"a", long_term, long_term + "r"});
+    std::vector<uint32_t> ids;
+    size_t longest = 0;
+    dictionary.forEach([&](std::string_view term, uint32_t id) {
+        ids.push_back(id);
+        longest = std::max(longest, term.size());
+    });
+    EXPECT_EQ(ids, (std::vector<uint32_t>{0, 1, 2}));
+    EXPECT_EQ(longest, long_term.size() + 1);
+    EXPECT_EQ(dictionary.find(long_term), 1u);
+    
+    // A runaway token is not indexed, and flushing and merging still work
+    createTestFile("long_doc.txt", std::string(2000000, 'z') + " tail");
+    engine.setFlushThreshold(1);
+    engine.addDocument("long", "long_doc.txt");
+    for (int i = 0; i < 4; i++) engine.addDocument("doc" + std::to_string(i), "test_doc1.txt");
+    engine.waitForMerges();
+    std::remove("long_doc.txt");
+    EXPECT_EQ(engine.getDocumentCount(), 5);
+    auto results = engine.search("tail");
+    ASSERT_EQ(results.size(), 1u);
+    EXPECT_EQ(results[0].first, "long");
+    EXPECT_TRUE(engine.search(std::string(2000000, 'z')).empty());
+}
+
+TEST(SpellCorrectorTest, MergesPendingWordsIntoDictionary) {
+    // Enough words to rebuild the automaton several times
+    SpellCorrector corrector;
+    for (int i = 0; i < 20000; i++) {
+        corrector.addWord("w" + std::to_string(i));
+    }
+    corrector.addWord("color", 1);
+    corrector.addWord("colour", 5);
+    corrector.addWord("w7", 3);
+    EXPECT_EQ(corrector.size(), 20002u);
+    EXPECT_TRUE(corrector.contains("w19999"));
+    EXPECT_FALSE(corrector.contains("w20000"));
+    
+    // Closest first, then most frequent
+    auto suggestions = corrector.getSuggestions("colr");
+    ASSERT_GE(suggestions.size(), 2u);
+    EXPECT_EQ(suggestions[0], "color");
+    EXPECT_EQ(suggestions[1], "colour");
+    EXPECT_EQ(corrector.getSuggestions("colou")[0], "colour");
+    EXPECT_EQ(corrector.getSuggestions("wx7")[0], "w7");
+    
+    BinaryWriter writer;
+    corrector.serialize(writer);
+    SpellCorrector loaded;
+    BinaryReader reader(writer.data().data(), writer.size());
+    loaded.deserialize(reader);
+    EXPECT_EQ(loaded.size(), corrector.size());
+    EXPECT_EQ(loaded.getSuggestions("colr"), suggestions);
+    EXPECT_EQ(loaded.getSuggestions("wx7"), corrector.getSuggestions("wx7"));
+}
+
+TEST(TrieTest, FuzzySuggestionsMatchBruteForce) {
+    std::mt19937 rng(25);
+    std::map<std::string, size_t> reference;
+    Trie trie(6);
+    for (int i = 0; i < 3000; i++) {
+        std::string word;
+        size_t length = 1 + rng() % 7;
+        for (size_t j = 0; j < length; j++) word += static_cast<char>('a' + rng() % 5);
+        size_t count = 1 + rng() % 4;
+        trie.insert(word, count);
+        reference[word] += count;
+    }
+    
+    auto distance = [](const std::string& a, const std::string& b) {
+        std::vector<size_t> row(b.size() + 1);
+        for (size_t j = 0; j <= b.size(); j++) row[j] = j;
+        for (size_t i = 1; i <= a.size(); i++) {
+            size_t diagonal = row[0];
+            row[0] = i;
+            for (size_t j = 1; j <= b.size(); j++) {
+                size_t above = row[j];
+                row[j] = std::min({row[j] + 1, row[j - 1] + 1, diagonal + (a[i - 1] != b[j - 1])});
+                diagonal = above;
+            }
+        }
+        return row[b.size()];
+    };
+    
+    // Closest prefix of each word first, then most frequent, then alphabetical
+    for (size_t max_distance : {0u, 1u, 2u}) {
+        for (const std::string prefix : {"", "a", "ab", "eca", "abcde", "bbbbbbbbb", "x"}) {
+            std::vector<std::tuple<size_t, size_t, std::string>> matches;
+            for (const auto& [word, frequency] : reference) {
+                size_t best = SIZE_MAX;
+                for (size_t j = 0; j <= word.size(); j++) {
+                    best = std::min(best, distance(prefix, word.substr(0, j)));
+                }
+                if (best <= max_distance) matches.emplace_back(best, SIZE_MAX - frequency, word);
+            }
+            std::sort(matches.begin(), matches.end());
+            std::vector<std::string> expected;
+            for (size_t i = 0; i < matches.size() && i < 6; i++) expected.push_back(std::get<2>(matches[i]));
+            EXPECT_EQ(trie.getFuzzySuggestions(prefix, max_distance), expected)
+                << prefix << " within " << max_distance;
+        }
+    }
+    EXPECT_EQ(trie.getFuzzySuggestions("abc", 0), trie.getSuggestions("abc"));
+}
+
+TEST_F(SearchEngineTest, FuzzyAutocompleteToleratesTypos) {
+    engine.addDocument("doc1", "test_doc1.txt");
+    engine.addDocument("doc2", "test_doc2.txt");
+    
+    EXPECT_TRUE(engine.getAutocompleteSuggestions("machne").empty());
+    auto suggestions = engine.getFuzzyAutocompleteSuggestions("machne");
+    ASSERT_FALSE(suggestions.empty());
+    EXPECT_EQ(suggestions[0], "machine");
+    
+    // An exact completion outranks one reached through an edit
+    suggestions = engine.getFuzzyAutocompleteSuggestions("neu", 2);
+    ASSERT_FALSE(suggestions.empty());
+    EXPECT_EQ(suggestions[0], "neural");
+    EXPECT_TRUE(engine.getFuzzyAutocompleteSuggestions("qqqqqq", 2).empty());
+}
\ No newline at end of file